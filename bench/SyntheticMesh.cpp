@@ -0,0 +1,473 @@
+#include "SyntheticMesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+namespace hecl::bench {
+namespace {
+constexpr float Pi = 3.14159265358979f;
+
+using Vec3 = std::array<float, 3>;
+using Vec2 = std::array<float, 2>;
+
+Vec3 Sub(const Vec3& a, const Vec3& b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+Vec3 Cross(const Vec3& a, const Vec3& b) {
+  return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+Vec3 Normalized(const Vec3& v) {
+  const float mag = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+  if (mag <= 0.f)
+    return {0.f, 0.f, 1.f};
+  return {v[0] / mag, v[1] / mag, v[2] / mag};
+}
+Vec3 TriNormal(const SyntheticMesh& mesh, const std::array<uint32_t, 3>& tri) {
+  const Vec3& a = mesh.positions[tri[0]];
+  return Normalized(Cross(Sub(mesh.positions[tri[1]], a), Sub(mesh.positions[tri[2]], a)));
+}
+
+void AddTri(SyntheticMesh& mesh, const std::array<uint32_t, 3>& verts, const std::array<Vec3, 3>& normals,
+            const std::array<Vec2, 3>& uvs, uint32_t material) {
+  mesh.tris.push_back(verts);
+  for (int c = 0; c < 3; ++c) {
+    mesh.cornerNormals.push_back(normals[c]);
+    mesh.cornerUVs.push_back(uvs[c]);
+  }
+  mesh.triMaterials.push_back(material);
+}
+
+/* Two triangles per quad, counter-clockwise from the (a, b, c, d) corner order */
+void AddQuad(SyntheticMesh& mesh, const std::array<uint32_t, 4>& verts, const std::array<Vec3, 4>& normals,
+             const std::array<Vec2, 4>& uvs, uint32_t material, bool flipDiagonal = false) {
+  if (flipDiagonal) {
+    AddTri(mesh, {verts[0], verts[1], verts[3]}, {normals[0], normals[1], normals[3]}, {uvs[0], uvs[1], uvs[3]},
+           material);
+    AddTri(mesh, {verts[1], verts[2], verts[3]}, {normals[1], normals[2], normals[3]}, {uvs[1], uvs[2], uvs[3]},
+           material);
+  } else {
+    AddTri(mesh, {verts[0], verts[1], verts[2]}, {normals[0], normals[1], normals[2]}, {uvs[0], uvs[1], uvs[2]},
+           material);
+    AddTri(mesh, {verts[0], verts[2], verts[3]}, {normals[0], normals[2], normals[3]}, {uvs[0], uvs[2], uvs[3]},
+           material);
+  }
+}
+
+/* Accumulates the payload of blender's framed output */
+class RecordingWriter {
+  std::vector<uint8_t> m_payload;
+
+public:
+  void writeBytes(const void* data, std::size_t len) {
+    const auto* ptr = static_cast<const uint8_t*>(data);
+    m_payload.insert(m_payload.end(), ptr, ptr + len);
+  }
+  void writeU32(uint32_t val) { writeBytes(&val, 4); }
+  void writeString(std::string_view str) {
+    writeU32(uint32_t(str.size()));
+    writeBytes(str.data(), str.size());
+  }
+
+  /* Bulk arrays are sent inline (tag 0) since a recording has no shared-memory region */
+  template <typename T>
+  void writeBulk(const std::vector<T>& data) {
+    const uint8_t tag = 0;
+    writeBytes(&tag, 1);
+    writeU32(uint32_t(data.size() * sizeof(T)));
+    writeBytes(data.data(), data.size() * sizeof(T));
+  }
+
+  std::vector<uint8_t> finish() const {
+    constexpr std::size_t MaxFrame = 1024 * 1024;
+    std::vector<uint8_t> ret;
+    ret.reserve(m_payload.size() + (m_payload.size() / MaxFrame + 1) * 4);
+    for (std::size_t off = 0; off < m_payload.size(); off += MaxFrame) {
+      const uint32_t frameLen = uint32_t(std::min(MaxFrame, m_payload.size() - off));
+      const auto* lenBytes = reinterpret_cast<const uint8_t*>(&frameLen);
+      ret.insert(ret.end(), lenBytes, lenBytes + 4);
+      ret.insert(ret.end(), m_payload.begin() + off, m_payload.begin() + off + frameLen);
+    }
+    return ret;
+  }
+};
+
+std::vector<float> Flatten(const std::vector<Vec3>& vecs) {
+  std::vector<float> ret;
+  ret.reserve(vecs.size() * 3);
+  for (const Vec3& v : vecs)
+    ret.insert(ret.end(), v.begin(), v.end());
+  return ret;
+}
+
+/* Mirrors HMDLMesh.write_mesh_attrs */
+void WriteMeshAttrs(RecordingWriter& w, const SyntheticMesh& mesh) {
+  constexpr uint32_t MeshFormatVersion = 2;
+  w.writeU32(MeshFormatVersion);
+  w.writeU32(0); /* color layers */
+  w.writeU32(1); /* uv layers */
+
+  /* Verts */
+  const uint32_t vertCount = uint32_t(mesh.positions.size());
+  w.writeU32(vertCount);
+  w.writeBulk(Flatten(mesh.positions));
+  std::vector<uint32_t> skinCounts(vertCount, 0);
+  std::vector<uint32_t> skinBinds;
+  if (!mesh.vertSkins.empty()) {
+    for (uint32_t v = 0; v < vertCount; ++v) {
+      auto binds = mesh.vertSkins[v];
+      std::sort(binds.begin(), binds.end());
+      float total = 0.f;
+      for (const auto& bind : binds)
+        total += bind.second;
+      skinCounts[v] = uint32_t(binds.size());
+      for (const auto& bind : binds) {
+        const float weight = bind.second / total;
+        uint32_t weightBits;
+        std::memcpy(&weightBits, &weight, 4);
+        skinBinds.push_back(bind.first);
+        skinBinds.push_back(weightBits);
+      }
+    }
+  }
+  w.writeBulk(skinCounts);
+  w.writeU32(uint32_t(skinBinds.size() / 2));
+  w.writeBulk(skinBinds);
+
+  /* Faces */
+  const uint32_t faceCount = uint32_t(mesh.tris.size());
+  w.writeU32(faceCount);
+  std::vector<Vec3> faceNormals;
+  std::vector<Vec3> faceCentroids;
+  std::vector<uint32_t> faceLoops;
+  faceNormals.reserve(faceCount);
+  faceCentroids.reserve(faceCount);
+  faceLoops.reserve(faceCount * 3);
+  for (uint32_t f = 0; f < faceCount; ++f) {
+    faceNormals.push_back(TriNormal(mesh, mesh.tris[f]));
+    Vec3 lo = mesh.positions[mesh.tris[f][0]];
+    Vec3 hi = lo;
+    for (uint32_t v : mesh.tris[f]) {
+      for (int c = 0; c < 3; ++c) {
+        lo[c] = std::min(lo[c], mesh.positions[v][c]);
+        hi[c] = std::max(hi[c], mesh.positions[v][c]);
+      }
+    }
+    faceCentroids.push_back({(lo[0] + hi[0]) * 0.5f, (lo[1] + hi[1]) * 0.5f, (lo[2] + hi[2]) * 0.5f});
+    for (uint32_t c = 0; c < 3; ++c)
+      faceLoops.push_back(f * 3 + c);
+  }
+  w.writeBulk(Flatten(faceNormals));
+  w.writeBulk(Flatten(faceCentroids));
+  w.writeBulk(mesh.triMaterials);
+  w.writeBulk(faceLoops);
+
+  /* Edges, in order of first use, and the loops running along each */
+  const uint32_t loopCount = faceCount * 3;
+  std::unordered_map<uint64_t, uint32_t> edgeMap;
+  std::vector<uint32_t> edgeVerts;
+  std::vector<std::vector<uint32_t>> edgeLoops;
+  std::vector<uint32_t> loopVerts(loopCount);
+  std::vector<uint32_t> loopEdges(loopCount);
+  std::vector<uint32_t> loopFaces(loopCount);
+  for (uint32_t l = 0; l < loopCount; ++l) {
+    const uint32_t f = l / 3;
+    const uint32_t a = mesh.tris[f][l % 3];
+    const uint32_t b = mesh.tris[f][(l + 1) % 3];
+    const uint64_t key = (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+    const auto [it, inserted] = edgeMap.try_emplace(key, uint32_t(edgeLoops.size()));
+    if (inserted) {
+      edgeVerts.push_back(a);
+      edgeVerts.push_back(b);
+      edgeLoops.emplace_back();
+    }
+    edgeLoops[it->second].push_back(l);
+    loopVerts[l] = a;
+    loopEdges[l] = it->second;
+    loopFaces[l] = f;
+  }
+
+  /* Loops */
+  w.writeU32(loopCount);
+  w.writeBulk(Flatten(mesh.cornerNormals));
+  std::vector<float> uvs;
+  uvs.reserve(loopCount * 2);
+  for (const Vec2& uv : mesh.cornerUVs)
+    uvs.insert(uvs.end(), uv.begin(), uv.end());
+  w.writeBulk(uvs);
+  w.writeBulk(loopVerts);
+  w.writeBulk(loopEdges);
+  w.writeBulk(loopFaces);
+
+  /* Contiguous edges join exactly two faces wound consistently */
+  const uint32_t edgeCount = uint32_t(edgeLoops.size());
+  std::vector<uint8_t> edgeContiguous(edgeCount);
+  for (uint32_t e = 0; e < edgeCount; ++e) {
+    const std::vector<uint32_t>& loops = edgeLoops[e];
+    edgeContiguous[e] = loops.size() == 2 && loopVerts[loops[0]] != loopVerts[loops[1]];
+  }
+  std::vector<uint32_t> loopNext(loopCount);
+  std::vector<uint32_t> loopPrev(loopCount);
+  std::vector<uint32_t> loopRadialNext(loopCount, UINT32_MAX);
+  std::vector<uint32_t> loopRadialPrev(loopCount, UINT32_MAX);
+  for (uint32_t l = 0; l < loopCount; ++l) {
+    const uint32_t base = l - l % 3;
+    loopNext[l] = base + (l + 1) % 3;
+    loopPrev[l] = base + (l + 2) % 3;
+    if (edgeContiguous[loopEdges[l]]) {
+      const std::vector<uint32_t>& loops = edgeLoops[loopEdges[l]];
+      loopRadialNext[l] = loopRadialPrev[l] = loops[0] == l ? loops[1] : loops[0];
+    }
+  }
+  w.writeBulk(loopNext);
+  w.writeBulk(loopPrev);
+  w.writeBulk(loopRadialNext);
+  w.writeBulk(loopRadialPrev);
+
+  /* Edges */
+  w.writeU32(edgeCount);
+  w.writeBulk(edgeVerts);
+  std::vector<uint32_t> edgeFaceCounts(edgeCount);
+  std::vector<uint32_t> edgeFaces;
+  for (uint32_t e = 0; e < edgeCount; ++e) {
+    edgeFaceCounts[e] = uint32_t(edgeLoops[e].size());
+    for (uint32_t l : edgeLoops[e])
+      edgeFaces.push_back(loopFaces[l]);
+  }
+  w.writeBulk(edgeFaceCounts);
+  w.writeU32(uint32_t(edgeFaces.size()));
+  w.writeBulk(edgeFaces);
+  w.writeBulk(edgeContiguous);
+}
+} // namespace
+
+SyntheticMesh MakeGrid(uint32_t quadsX, uint32_t quadsY, uint32_t materialCount) {
+  SyntheticMesh mesh;
+  mesh.name = "grid";
+  mesh.materialCount = std::max(1u, materialCount);
+  const uint32_t rowVerts = quadsX + 1;
+  for (uint32_t y = 0; y <= quadsY; ++y)
+    for (uint32_t x = 0; x <= quadsX; ++x)
+      mesh.positions.push_back({float(x), float(y), 0.f});
+
+  const Vec3 up = {0.f, 0.f, 1.f};
+  for (uint32_t y = 0; y < quadsY; ++y) {
+    for (uint32_t x = 0; x < quadsX; ++x) {
+      const uint32_t v00 = y * rowVerts + x;
+      auto uv = [&](uint32_t ux, uint32_t uy) { return Vec2{float(ux) / quadsX, float(uy) / quadsY}; };
+      AddQuad(mesh, {v00, v00 + 1, v00 + rowVerts + 1, v00 + rowVerts}, {up, up, up, up},
+              {uv(x, y), uv(x + 1, y), uv(x + 1, y + 1), uv(x, y + 1)}, y * mesh.materialCount / quadsY);
+    }
+  }
+  return mesh;
+}
+
+SyntheticMesh MakeSphere(uint32_t segments, uint32_t rings) {
+  SyntheticMesh mesh;
+  mesh.name = "sphere";
+  /* Pole verts first, then one ring of segments verts per interior latitude */
+  mesh.positions.push_back({0.f, 0.f, 1.f});
+  mesh.positions.push_back({0.f, 0.f, -1.f});
+  for (uint32_t r = 1; r < rings; ++r) {
+    const float theta = Pi * r / rings;
+    for (uint32_t s = 0; s < segments; ++s) {
+      const float phi = 2.f * Pi * s / segments;
+      mesh.positions.push_back({std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta)});
+    }
+  }
+
+  auto vert = [&](uint32_t r, uint32_t s) -> uint32_t {
+    if (r == 0)
+      return 0;
+    if (r == rings)
+      return 1;
+    return 2 + (r - 1) * segments + s % segments;
+  };
+  /* The seam meridian gets u = 1 on the faces that close the ring */
+  auto uv = [&](uint32_t r, uint32_t s) { return Vec2{float(s) / segments, 1.f - float(r) / rings}; };
+  for (uint32_t r = 0; r < rings; ++r) {
+    for (uint32_t s = 0; s < segments; ++s) {
+      const std::array<uint32_t, 4> v = {vert(r, s), vert(r + 1, s), vert(r + 1, s + 1), vert(r, s + 1)};
+      const std::array<Vec3, 4> n = {mesh.positions[v[0]], mesh.positions[v[1]], mesh.positions[v[2]],
+                                     mesh.positions[v[3]]};
+      const std::array<Vec2, 4> t = {uv(r, s), uv(r + 1, s), uv(r + 1, s + 1), uv(r, s + 1)};
+      if (r == 0)
+        AddTri(mesh, {v[0], v[1], v[2]}, {n[0], n[1], n[2]}, {t[0], t[1], t[2]}, 0);
+      else if (r == rings - 1)
+        AddTri(mesh, {v[0], v[1], v[3]}, {n[0], n[1], n[3]}, {t[0], t[1], t[3]}, 0);
+      else
+        AddQuad(mesh, v, n, t, 0);
+    }
+  }
+  return mesh;
+}
+
+SyntheticMesh MakeTorus(uint32_t segments, uint32_t sides) {
+  SyntheticMesh mesh;
+  mesh.name = "torus";
+  constexpr float MajorRadius = 1.f;
+  constexpr float MinorRadius = 0.3f;
+  std::vector<Vec3> normals;
+  for (uint32_t s = 0; s < segments; ++s) {
+    const float phi = 2.f * Pi * s / segments;
+    for (uint32_t t = 0; t < sides; ++t) {
+      const float theta = 2.f * Pi * t / sides;
+      const Vec3 n = {std::cos(theta) * std::cos(phi), std::cos(theta) * std::sin(phi), std::sin(theta)};
+      mesh.positions.push_back({(MajorRadius + MinorRadius * std::cos(theta)) * std::cos(phi),
+                                (MajorRadius + MinorRadius * std::cos(theta)) * std::sin(phi),
+                                MinorRadius * std::sin(theta)});
+      normals.push_back(n);
+    }
+  }
+
+  auto vert = [&](uint32_t s, uint32_t t) { return (s % segments) * sides + t % sides; };
+  auto uv = [&](uint32_t s, uint32_t t) { return Vec2{float(s) / segments, float(t) / sides}; };
+  for (uint32_t s = 0; s < segments; ++s) {
+    for (uint32_t t = 0; t < sides; ++t) {
+      const std::array<uint32_t, 4> v = {vert(s, t), vert(s + 1, t), vert(s + 1, t + 1), vert(s, t + 1)};
+      AddQuad(mesh, v, {normals[v[0]], normals[v[1]], normals[v[2]], normals[v[3]]},
+              {uv(s, t), uv(s + 1, t), uv(s + 1, t + 1), uv(s, t + 1)}, 0);
+    }
+  }
+  return mesh;
+}
+
+SyntheticMesh MakeIrregular(uint32_t quadsX, uint32_t quadsY, uint32_t seed) {
+  SyntheticMesh mesh;
+  mesh.name = "irregular";
+  mesh.materialCount = 4;
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> jitter(-0.3f, 0.3f);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+  const uint32_t rowVerts = quadsX + 1;
+  for (uint32_t y = 0; y <= quadsY; ++y)
+    for (uint32_t x = 0; x <= quadsX; ++x)
+      mesh.positions.push_back({x + jitter(rng), y + jitter(rng),
+                                2.f * std::sin(x * 0.21f) * std::cos(y * 0.17f) + jitter(rng)});
+
+  /* Pick diagonals and flat-shaded patches first so smooth normals can be accumulated */
+  struct Quad {
+    std::array<uint32_t, 4> verts;
+    bool flip;
+    bool flat;
+  };
+  std::vector<Quad> quads;
+  quads.reserve(std::size_t(quadsX) * quadsY);
+  std::vector<Vec3> smooth(mesh.positions.size(), Vec3{0.f, 0.f, 0.f});
+  for (uint32_t y = 0; y < quadsY; ++y) {
+    for (uint32_t x = 0; x < quadsX; ++x) {
+      const uint32_t v00 = y * rowVerts + x;
+      Quad& q = quads.emplace_back();
+      q.verts = {v00, v00 + 1, v00 + rowVerts + 1, v00 + rowVerts};
+      q.flip = unit(rng) < 0.5f;
+      q.flat = ((x / 8) * 7 + (y / 8) * 13) % 10 == 0;
+      const Vec3 n = Cross(Sub(mesh.positions[q.verts[2]], mesh.positions[q.verts[0]]),
+                           Sub(mesh.positions[q.verts[3]], mesh.positions[q.verts[1]]));
+      for (uint32_t v : q.verts)
+        for (int c = 0; c < 3; ++c)
+          smooth[v][c] += n[c];
+    }
+  }
+  for (Vec3& n : smooth)
+    n = Normalized(n);
+
+  std::size_t q = 0;
+  for (uint32_t y = 0; y < quadsY; ++y) {
+    for (uint32_t x = 0; x < quadsX; ++x) {
+      const Quad& quad = quads[q++];
+      std::array<Vec3, 4> n;
+      if (quad.flat) {
+        const Vec3 flat = Normalized(Cross(Sub(mesh.positions[quad.verts[2]], mesh.positions[quad.verts[0]]),
+                                           Sub(mesh.positions[quad.verts[3]], mesh.positions[quad.verts[1]])));
+        n = {flat, flat, flat, flat};
+      } else {
+        n = {smooth[quad.verts[0]], smooth[quad.verts[1]], smooth[quad.verts[2]], smooth[quad.verts[3]]};
+      }
+      auto uv = [&](uint32_t ux, uint32_t uy) { return Vec2{float(ux) / quadsX, float(uy) / quadsY}; };
+      const uint32_t material = (x * 2 / quadsX) + (y * 2 / quadsY) * 2;
+      AddQuad(mesh, quad.verts, n, {uv(x, y), uv(x + 1, y), uv(x + 1, y + 1), uv(x, y + 1)}, material, quad.flip);
+    }
+  }
+  return mesh;
+}
+
+SyntheticMesh MakeRiggedCylinder(uint32_t segments, uint32_t rings, uint32_t boneCount) {
+  SyntheticMesh mesh;
+  mesh.name = "rigged cylinder";
+  mesh.boneCount = std::max(1u, boneCount);
+  std::vector<Vec3> normals;
+  for (uint32_t r = 0; r <= rings; ++r) {
+    const float z = float(r) / rings;
+    /* Bone b is centered at (b + 0.5) / boneCount; blend the two bones around z */
+    const float bonePos = std::clamp(z * mesh.boneCount - 0.5f, 0.f, float(mesh.boneCount - 1));
+    const uint32_t bone = std::min(uint32_t(bonePos), mesh.boneCount - 1);
+    const float blend = bonePos - bone;
+    for (uint32_t s = 0; s < segments; ++s) {
+      const float phi = 2.f * Pi * s / segments;
+      mesh.positions.push_back({std::cos(phi), std::sin(phi), z * 8.f});
+      normals.push_back({std::cos(phi), std::sin(phi), 0.f});
+      auto& skin = mesh.vertSkins.emplace_back();
+      skin.emplace_back(bone, 1.f - blend);
+      if (blend > 0.f && bone + 1 < mesh.boneCount)
+        skin.emplace_back(bone + 1, blend);
+    }
+  }
+
+  auto vert = [&](uint32_t r, uint32_t s) { return r * segments + s % segments; };
+  auto uv = [&](uint32_t r, uint32_t s) { return Vec2{float(s) / segments, float(r) / rings}; };
+  for (uint32_t r = 0; r < rings; ++r) {
+    for (uint32_t s = 0; s < segments; ++s) {
+      const std::array<uint32_t, 4> v = {vert(r, s), vert(r, s + 1), vert(r + 1, s + 1), vert(r + 1, s)};
+      AddQuad(mesh, v, {normals[v[0]], normals[v[1]], normals[v[2]], normals[v[3]]},
+              {uv(r, s), uv(r, s + 1), uv(r + 1, s + 1), uv(r + 1, s)}, 0);
+    }
+  }
+  return mesh;
+}
+
+std::vector<uint8_t> RecordMesh(const SyntheticMesh& mesh) {
+  RecordingWriter w;
+
+  /* Scene transform and bounds */
+  const float identity[16] = {1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f};
+  w.writeBytes(identity, sizeof(identity));
+  Vec3 lo = mesh.positions.empty() ? Vec3{} : mesh.positions[0];
+  Vec3 hi = lo;
+  for (const Vec3& p : mesh.positions) {
+    for (int c = 0; c < 3; ++c) {
+      lo[c] = std::min(lo[c], p[c]);
+      hi[c] = std::max(hi[c], p[c]);
+    }
+  }
+  w.writeBytes(lo.data(), 12);
+  w.writeBytes(hi.data(), 12);
+
+  /* One material set of untextured materials */
+  w.writeU32(1);
+  w.writeU32(mesh.materialCount);
+  for (uint32_t i = 0; i < mesh.materialCount; ++i) {
+    w.writeString("material" + std::to_string(i));
+    w.writeU32(i); /* pass index */
+    w.writeU32(0); /* shader type */
+    w.writeU32(0); /* chunks */
+    w.writeU32(0); /* integer properties */
+    w.writeU32(0); /* blend mode */
+  }
+
+  WriteMeshAttrs(w, mesh);
+
+  w.writeU32(mesh.boneCount);
+  for (uint32_t i = 0; i < mesh.boneCount; ++i)
+    w.writeString("bone" + std::to_string(i));
+  w.writeU32(0); /* custom properties */
+  return w.finish();
+}
+
+std::vector<uint8_t> RecordMeshAttributes(const SyntheticMesh& mesh) {
+  RecordingWriter w;
+  WriteMeshAttrs(w, mesh);
+  return w.finish();
+}
+
+} // namespace hecl::bench
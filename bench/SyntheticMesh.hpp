@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hecl::bench {
+
+/**
+ * @brief Triangulated mesh in the form blender's MESHCOMPILE sends it
+ *
+ * Normals and UVs are per corner (three per triangle), so hard edges and UV seams are
+ * expressed the way blender expresses them. vertSkins is empty for unrigged meshes.
+ */
+struct SyntheticMesh {
+  std::string name;
+  std::vector<std::array<float, 3>> positions;
+  std::vector<std::array<uint32_t, 3>> tris;
+  std::vector<std::array<float, 3>> cornerNormals;
+  std::vector<std::array<float, 2>> cornerUVs;
+  std::vector<uint32_t> triMaterials;
+  std::vector<std::vector<std::pair<uint32_t, float>>> vertSkins;
+  uint32_t materialCount = 1;
+  uint32_t boneCount = 0;
+};
+
+/** Smooth, seamless plane of quadsX * quadsY quads, banded into materialCount materials */
+SyntheticMesh MakeGrid(uint32_t quadsX, uint32_t quadsY, uint32_t materialCount = 1);
+
+/** UV sphere with a UV seam along one meridian and triangle fans at the poles */
+SyntheticMesh MakeSphere(uint32_t segments, uint32_t rings);
+
+/** Torus with UV seams around both of its circles */
+SyntheticMesh MakeTorus(uint32_t segments, uint32_t sides);
+
+/** Jittered grid with random diagonals, flat-shaded patches and four materials, like scanned terrain */
+SyntheticMesh MakeIrregular(uint32_t quadsX, uint32_t quadsY, uint32_t seed = 1);
+
+/** Cylinder rigged to boneCount bones along its length, each vert blending its two nearest bones */
+SyntheticMesh MakeRiggedCylinder(uint32_t segments, uint32_t rings, uint32_t boneCount);
+
+/** Framed blender output for DataStream::compileMesh(): transform, materials, attributes, bones, properties */
+std::vector<uint8_t> RecordMesh(const SyntheticMesh& mesh);
+
+/** Framed blender output for the attribute columns alone, as read by MeshOptimizer */
+std::vector<uint8_t> RecordMeshAttributes(const SyntheticMesh& mesh);
+
+} // namespace hecl::bench
@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <numeric>
+#include <random>
+
+#if _WIN32
+#include <io.h>
+#define dup _dup
+#else
+#include <unistd.h>
+#endif
+
+#include "hecl/Blender/Connection.hpp"
+#include "hecl/HMDLMeta.hpp"
+#include "logvisor/logvisor.hpp"
+
+#include "MeshOptimizer.hpp"
+#include "SyntheticMesh.hpp"
+
+/* Synthetic workloads for the blender mesh readers, replayed from recorded blender output so
+ * no blender process is needed. Timings are the best of several runs. */
+
+using namespace hecl::bench;
+using namespace std::literals;
+
+namespace {
+logvisor::Module Log("hecl::Bench");
+constexpr int Runs = 5;
+
+double BestOfMs(const std::function<void()>& func) {
+  double best = 0.0;
+  for (int i = 0; i < Runs; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    best = i ? std::min(best, ms) : ms;
+  }
+  return best;
+}
+
+/** Replays a recording through a fresh connection; the connection owns the returned descriptor */
+int OpenRecording(const std::vector<uint8_t>& recording) {
+  std::FILE* fp = std::tmpfile();
+  if (!fp)
+    Log.report(logvisor::Fatal, FMT_STRING("unable to create recording file"));
+  std::fwrite(recording.data(), 1, recording.size(), fp);
+  std::fflush(fp);
+  std::rewind(fp);
+  const int fd = dup(fileno(fp));
+  std::fclose(fp);
+  return fd;
+}
+
+hecl::blender::Mesh ReadMesh(const std::vector<uint8_t>& recording, int skinSlotCount) {
+  hecl::blender::Connection conn(hecl::blender::Connection::FromRecording{OpenRecording(recording)});
+  return hecl::blender::Mesh(conn, hecl::HMDLTopology::TriStrips, skinSlotCount);
+}
+
+void BenchHMDLBuffers(const SyntheticMesh& synth) {
+  const std::vector<uint8_t> recording = RecordMesh(synth);
+  const hecl::blender::Mesh mesh = ReadMesh(recording, 16);
+
+  const auto packed = hecl::HMDLFlags::VertexPackingMask | hecl::HMDLFlags::ShortIndices;
+  for (const auto packing : {hecl::HMDLFlags::None, packed}) {
+    std::size_t vboSz = 0;
+    std::size_t iboSz = 0;
+    const double ms = BestOfMs([&]() {
+      hecl::blender::PoolSkinIndex poolSkinIndex;
+      const hecl::blender::HMDLBuffers bufs = mesh.getHMDLBuffers(false, poolSkinIndex, packing);
+      vboSz = bufs.m_vboSz;
+      iboSz = bufs.m_iboSz;
+    });
+    fmt::print(FMT_STRING("getHMDLBuffers  {:<16} {:>8} tris  {:<6}  {:9.3f} ms  vbo {:>9}  ibo {:>9}\n"), synth.name,
+               synth.tris.size(), packing == hecl::HMDLFlags::None ? "float"sv : "packed"sv, ms, vboSz, iboSz);
+  }
+}
+} // namespace
+
+namespace hecl::blender {
+struct MeshOptimizerBench {
+  /* Faces in mesh order, as optimize() hands them over, and shuffled to scatter skin first-use */
+  static void SortFacesBySkinGroup(const SyntheticMesh& synth) {
+    const Mesh mesh = ReadMesh(RecordMesh(synth), 16);
+    const std::vector<uint8_t> recording = RecordMeshAttributes(synth);
+    Connection conn(Connection::FromRecording{OpenRecording(recording)});
+    const MeshOptimizer opt(conn, mesh.materialSets[0], false);
+
+    std::vector<uint32_t> meshOrder(opt.faces.size());
+    std::iota(meshOrder.begin(), meshOrder.end(), 0);
+    std::vector<uint32_t> shuffled(meshOrder);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(1));
+
+    for (const auto& [order, faces] : {std::pair{"mesh"sv, &meshOrder}, std::pair{"shuffled"sv, &shuffled}}) {
+      std::vector<uint32_t> sorted;
+      const double ms = BestOfMs([&]() {
+        sorted = *faces;
+        opt.sort_faces_by_skin_group(sorted);
+      });
+      fmt::print(FMT_STRING("sortFacesBySkin {:<16} {:>8} tris  {:<8}  {:9.3f} ms  {} skins\n"), synth.name,
+                 synth.tris.size(), order, ms, opt.b_skin.size());
+    }
+  }
+};
+} // namespace hecl::blender
+
+int main() {
+  logvisor::RegisterStandardExceptions();
+  logvisor::RegisterConsoleLogger();
+
+  for (const uint32_t quads : {16u, 64u, 256u, 512u})
+    BenchHMDLBuffers(MakeGrid(quads, quads, 4));
+  BenchHMDLBuffers(MakeSphere(128, 64));
+  BenchHMDLBuffers(MakeTorus(256, 64));
+  BenchHMDLBuffers(MakeIrregular(256, 256));
+  BenchHMDLBuffers(MakeRiggedCylinder(64, 256, 16));
+
+  for (const uint32_t rings : {64u, 256u, 1024u})
+    hecl::blender::MeshOptimizerBench::SortFacesBySkinGroup(MakeRiggedCylinder(64, rings, 32));
+
+  return 0;
+}
@@ -1,100 +1,151 @@
 import bpy, bmesh, operator, struct
+from array import array
 
-# Function to quantize normals to 15-bit precision
-def quant_norm(n):
-    nf = n.copy()
-    for i in range(3):
-        nf[i] = int(nf[i] * 16384) / 16384.0
-    return nf.freeze()
+# Function to quantize normal components to 15-bit precision
+def quant_norm_component(f):
+    return int(f * 16384) / 16384.0
 
-# Function to quantize lightmap UVs to 15-bit precision
-def quant_luv(n):
-    uf = n.copy()
-    for i in range(2):
-        uf[i] = int(uf[i] * 32768) / 32768.0
-    return uf.freeze()
+# Function to quantize lightmap UV components to 15-bit precision
+def quant_luv_component(f):
+    return int(f * 32768) / 32768.0
+
+# Version of the columnar layout emitted by write_mesh_attrs; checked by HECL's MeshOptimizer
+MESH_FORMAT_VERSION = 2
 
 # Function to output all mesh attribute values
-def write_mesh_attrs(writebuf, bm, rna_loops, use_luv, material_slots):
+#
+# Each attribute is sent as its own array (through writebulk) rather than
+# interleaved per element; only the color and UV layers that exist are sent.
+def write_mesh_attrs(writebuf, writebulk, bm, mesh, use_luv, material_slots):
+    writebuf(struct.pack('I', MESH_FORMAT_VERSION))
+
     dlay = None
     if len(bm.verts.layers.deform):
         dlay = bm.verts.layers.deform[0]
 
-    clays = []
-    for cl in range(len(bm.loops.layers.color)):
-        clays.append(bm.loops.layers.color[cl])
-    writebuf(struct.pack('I', len(clays)))
-
-    luvlay = None
-    if use_luv:
-        luvlay = bm.loops.layers.uv[0]
-    ulays = []
-    for ul in range(len(bm.loops.layers.uv)):
-        ulays.append(bm.loops.layers.uv[ul])
-    writebuf(struct.pack('I', len(ulays)))
+    color_layers = mesh.vertex_colors
+    uv_layers = mesh.uv_layers
+    writebuf(struct.pack('II', len(color_layers), len(uv_layers)))
 
     # Verts
-    writebuf(struct.pack('I', len(bm.verts)))
-    for v in bm.verts:
-        writebuf(struct.pack('fff', v.co[0], v.co[1], v.co[2]))
-        if dlay:
+    vert_count = len(mesh.vertices)
+    writebuf(struct.pack('I', vert_count))
+    vert_cos = array('f', [0.0]) * (vert_count * 3)
+    mesh.vertices.foreach_get('co', vert_cos)
+    writebulk(vert_cos)
+
+    # Skin binds: per-vertex bind count, then all (group, weight) pairs
+    skin_counts = array('I', [0]) * vert_count
+    skin_binds = bytearray()
+    if dlay:
+        for v in bm.verts:
             sf = tuple(sorted(v[dlay].items()))
-            writebuf(struct.pack('I', len(sf)))
+            skin_counts[v.index] = len(sf)
             total_len = 0.0
             for ent in sf:
                 total_len += ent[1]
             for ent in sf:
-                writebuf(struct.pack('If', ent[0], ent[1] / total_len))
-        else:
-            writebuf(struct.pack('I', 0))
+                skin_binds += struct.pack('If', ent[0], ent[1] / total_len)
+    writebulk(skin_counts)
+    writebuf(struct.pack('I', len(skin_binds) // 8))
+    writebulk(skin_binds)
+
+    # Faces
+    face_count = len(bm.faces)
+    writebuf(struct.pack('I', face_count))
+    face_norms = array('f', [0.0]) * (face_count * 3)
+    mesh.polygons.foreach_get('normal', face_norms)
+    writebulk(face_norms)
+    face_centroids = array('f', [0.0]) * (face_count * 3)
+    face_loops = array('I', [0]) * (face_count * 3)
+    for f in bm.faces:
+        centroid = f.calc_center_bounds()
+        face_centroids[f.index * 3:f.index * 3 + 3] = array('f', centroid)
+        for i, l in enumerate(f.loops):
+            face_loops[f.index * 3 + i] = l.index
+    writebulk(face_centroids)
+    face_materials = array('i', [0]) * face_count
+    mesh.polygons.foreach_get('material_index', face_materials)
+    writebulk(face_materials)
+    writebulk(face_loops)
 
     # Loops
-    loop_count = 0
+    loop_count = len(mesh.loops)
+    writebuf(struct.pack('I', loop_count))
+    loop_norms = array('f', [0.0]) * (loop_count * 3)
+    mesh.loops.foreach_get('normal', loop_norms)
+    writebulk(array('f', [quant_norm_component(n) for n in loop_norms]))
+
+    for cl in color_layers:
+        rgba = array('f', [0.0]) * (loop_count * 4)
+        cl.data.foreach_get('color', rgba)
+        rgb = array('f', [0.0]) * (loop_count * 3)
+        rgb[0::3] = rgba[0::4]
+        rgb[1::3] = rgba[1::4]
+        rgb[2::3] = rgba[2::4]
+        writebulk(rgb)
+
+    lightmapped = {}
+    def face_lightmapped(face_idx):
+        mat_idx = face_materials[face_idx]
+        if mat_idx not in lightmapped:
+            lightmapped[mat_idx] = bool(material_slots[mat_idx].material['retro_lightmapped'])
+        return lightmapped[mat_idx]
+
+    loop_faces = array('I', [0]) * loop_count
     for f in bm.faces:
         for l in f.loops:
-            loop_count += 1
-    writebuf(struct.pack('I', loop_count))
+            loop_faces[l.index] = f.index
+
+    for ul_idx, ul in enumerate(uv_layers):
+        uvs = array('f', [0.0]) * (loop_count * 2)
+        ul.data.foreach_get('uv', uvs)
+        if use_luv and ul_idx == 0:
+            for li in range(loop_count):
+                if face_lightmapped(loop_faces[li]):
+                    uvs[li * 2] = quant_luv_component(uvs[li * 2])
+                    uvs[li * 2 + 1] = quant_luv_component(uvs[li * 2 + 1])
+        writebulk(uvs)
+
+    loop_verts = array('i', [0]) * loop_count
+    mesh.loops.foreach_get('vertex_index', loop_verts)
+    writebulk(loop_verts)
+    loop_edges = array('i', [0]) * loop_count
+    mesh.loops.foreach_get('edge_index', loop_edges)
+    writebulk(loop_edges)
+    writebulk(loop_faces)
+
+    loop_next = array('I', [0]) * loop_count
+    loop_prev = array('I', [0]) * loop_count
+    loop_radial_next = array('I', [0xffffffff]) * loop_count
+    loop_radial_prev = array('I', [0xffffffff]) * loop_count
     for f in bm.faces:
         for l in f.loops:
-            if rna_loops:
-                nf = quant_norm(rna_loops[l.index].normal)
-            else:
-                nf = quant_norm(l.vert.normal)
-            writebuf(struct.pack('fff', nf[0], nf[1], nf[2]))
-            for cl in range(len(clays)):
-                col = l[clays[cl]]
-                writebuf(struct.pack('fff', col[0], col[1], col[2]))
-            for cl in range(len(ulays)):
-                if luvlay and cl == 0 and material_slots[l.face.material_index].material['retro_lightmapped']:
-                    uv = quant_luv(l[luvlay].uv)
-                else:
-                    uv = l[ulays[cl]].uv
-                writebuf(struct.pack('ff', uv[0], uv[1]))
-            writebuf(struct.pack('IIIII', l.vert.index, l.edge.index, l.face.index,
-                                 l.link_loop_next.index, l.link_loop_prev.index))
+            loop_next[l.index] = l.link_loop_next.index
+            loop_prev[l.index] = l.link_loop_prev.index
             if l.edge.is_contiguous:
-                writebuf(struct.pack('II', l.link_loop_radial_next.index, l.link_loop_radial_prev.index))
-            else:
-                writebuf(struct.pack('II', 0xffffffff, 0xffffffff))
+                loop_radial_next[l.index] = l.link_loop_radial_next.index
+                loop_radial_prev[l.index] = l.link_loop_radial_prev.index
+    writebulk(loop_next)
+    writebulk(loop_prev)
+    writebulk(loop_radial_next)
+    writebulk(loop_radial_prev)
 
     # Edges
-    writebuf(struct.pack('I', len(bm.edges)))
+    edge_count = len(bm.edges)
+    writebuf(struct.pack('I', edge_count))
+    edge_verts = array('i', [0]) * (edge_count * 2)
+    mesh.edges.foreach_get('vertices', edge_verts)
+    writebulk(edge_verts)
+    edge_face_counts = array('I', [0]) * edge_count
+    edge_faces = array('I')
+    edge_contiguous = bytearray(edge_count)
     for e in bm.edges:
-        for v in e.verts:
-            writebuf(struct.pack('I', v.index))
-        writebuf(struct.pack('I', len(e.link_faces)))
+        edge_face_counts[e.index] = len(e.link_faces)
         for f in e.link_faces:
-            writebuf(struct.pack('I', f.index))
-        writebuf(struct.pack('b', e.is_contiguous))
-
-    # Faces
-    writebuf(struct.pack('I', len(bm.faces)))
-    for f in bm.faces:
-        norm = f.normal
-        writebuf(struct.pack('fff', norm[0], norm[1], norm[2]))
-        centroid = f.calc_center_bounds()
-        writebuf(struct.pack('fff', centroid[0], centroid[1], centroid[2]))
-        writebuf(struct.pack('I', f.material_index))
-        for l in f.loops:
-            writebuf(struct.pack('I', l.index))
-
+            edge_faces.append(f.index)
+        edge_contiguous[e.index] = e.is_contiguous
+    writebulk(edge_face_counts)
+    writebuf(struct.pack('I', len(edge_faces)))
+    writebulk(edge_faces)
+    writebulk(edge_contiguous)
@@ -1,4 +1,5 @@
 import struct, bpy, bmesh
+from array import array
 from . import HMDLShader, HMDLMesh
 
 BLEND_TYPES = {
@@ -33,7 +34,7 @@ def write_out_material(writebuf, mat, mesh_obj):
 
 # Takes a Blender 'Mesh' object (not the datablock)
 # and performs a one-shot conversion process to HMDL
-def cook(writebuf, mesh_obj, use_luv=False):
+def cook(writebuf, writebulk, mesh_obj, use_luv=False):
     if mesh_obj.type != 'MESH':
         raise RuntimeError("%s is not a mesh" % mesh_obj.name)
 
@@ -54,7 +55,6 @@ def cook(writebuf, mesh_obj, use_luv=False):
     bpy.context.scene.update_tag()
     bpy.ops.object.mode_set(mode='OBJECT')
     copy_mesh.calc_normals_split()
-    rna_loops = copy_mesh.loops
 
     # Send scene matrix
     wmtx = mesh_obj.matrix_world
@@ -98,7 +98,7 @@ def cook(writebuf, mesh_obj, use_luv=False):
             write_out_material(writebuf, mat, mesh_obj)
 
     # Output attribute lists
-    HMDLMesh.write_mesh_attrs(writebuf, bm_master, rna_loops, use_luv, mesh_obj.material_slots)
+    HMDLMesh.write_mesh_attrs(writebuf, writebulk, bm_master, copy_mesh, use_luv, mesh_obj.material_slots)
 
     # Vertex groups
     writebuf(struct.pack('I', len(mesh_obj.vertex_groups)))
@@ -129,7 +129,7 @@ def prop_val_from_colmat(name, m):
 
 # Takes a Blender 'Mesh' object (not the datablock)
 # and performs a one-shot conversion process to collision geometry
-def cookcol(writebuf, mesh_obj):
+def cookcol(writebuf, writebulk, mesh_obj):
     if mesh_obj.type != 'MESH':
         raise RuntimeError("%s is not a mesh" % mesh_obj.name)
 
@@ -222,16 +222,23 @@ def cookcol(writebuf, mesh_obj):
                  seeThrough, scanPassthrough, aiPassthrough, ceiling, wall, floor, aiBlock, jumpNotAllowed, spiderBall,
                  screwAttackWallJump))
 
-    # Send verts
-    writebuf(struct.pack('I', len(copy_mesh.vertices)))
-    for v in copy_mesh.vertices:
-        xfVert = wmtx @ v.co
-        writebuf(struct.pack('fff', xfVert[0], xfVert[1], xfVert[2]))
-
-    # Send edges
-    writebuf(struct.pack('I', len(copy_mesh.edges)))
-    for e in copy_mesh.edges:
-        writebuf(struct.pack('IIb', e.vertices[0], e.vertices[1], e.use_seam))
+    # Send verts (as a whole array, in world space)
+    copy_mesh.transform(wmtx)
+    vert_count = len(copy_mesh.vertices)
+    vert_cos = array('f', [0.0]) * (vert_count * 3)
+    copy_mesh.vertices.foreach_get('co', vert_cos)
+    writebuf(struct.pack('I', vert_count))
+    writebulk(vert_cos)
+
+    # Send edges (vertex pairs, then seam flags)
+    edge_count = len(copy_mesh.edges)
+    edge_verts = array('i', [0]) * (edge_count * 2)
+    copy_mesh.edges.foreach_get('vertices', edge_verts)
+    edge_seams = [False] * edge_count
+    copy_mesh.edges.foreach_get('use_seam', edge_seams)
+    writebuf(struct.pack('I', edge_count))
+    writebulk(edge_verts)
+    writebulk(bytes(edge_seams))
 
     # Send trianges
     writebuf(struct.pack('I', len(copy_mesh.polygons)))
@@ -291,7 +298,7 @@ class hecl_mesh_operator(bpy.types.Operator):
         return context.object and context.object.type == 'MESH'
 
     def execute(self, context):
-        cook(fake_writebuf, context.object, -1)
+        cook(fake_writebuf, fake_writebuf, context.object, -1)
         return {'FINISHED'}
 
 import bpy
@@ -1,4 +1,4 @@
-import bpy, sys, os, re, struct, traceback
+import bpy, sys, os, re, struct, traceback, mmap
 
 ARGS_PATTERN = re.compile(r'''(?:"([^"]+)"|'([^']+)'|(\S+))''')
 
@@ -17,6 +17,8 @@ args = sys.argv[sys.argv.index('--')+1:]
 readfd = int(args[0])
 writefd = int(args[1])
 verbosity_level = int(args[2])
+# Optional shared-memory region for bulk array transfers
+bulkfd = int(args[4]) if len(args) >= 5 else -1
 err_path = ""
 if sys.platform == "win32":
     import msvcrt
@@ -32,25 +34,94 @@ else:
 
 err_path += "/hecl_%016X.derp" % os.getpid()
 
+# Output to HECL is buffered and sent as [u32 length][payload] frames, flushed before
+# every read from HECL (and whenever the buffer grows large). Exceptions are reported
+# with a status frame: [u32 0xFFFFFFFF][u32 length][message]
+STATUS_FRAME = 0xFFFFFFFF
+FLUSH_THRESHOLD = 256 * 1024
+write_buffer = bytearray()
+
+def _writeall(data):
+    view = memoryview(data)
+    while len(view):
+        view = view[os.write(writefd, view):]
+
+def flushpipe():
+    if len(write_buffer):
+        _writeall(struct.pack('I', len(write_buffer)))
+        _writeall(write_buffer)
+        write_buffer.clear()
+
+def writepipestatus(msgbytes):
+    flushpipe()
+    _writeall(struct.pack('II', STATUS_FRAME, len(msgbytes)))
+    _writeall(msgbytes)
+
+def readpipebuf(read_len):
+    flushpipe()
+    read_bytes = bytearray()
+    while len(read_bytes) < read_len:
+        chunk = os.read(readfd, read_len - len(read_bytes))
+        if not len(chunk):
+            print('HECL connection lost or desynchronized')
+            _quitblender()
+        read_bytes += chunk
+    return bytes(read_bytes)
+
 def readpipestr():
-    read_bytes = os.read(readfd, 4)
-    if len(read_bytes) != 4:
-        print('HECL connection lost or desynchronized')
-        _quitblender()
-    read_len = struct.unpack('I', read_bytes)[0]
-    return os.read(readfd, read_len)
+    read_len = struct.unpack('I', readpipebuf(4))[0]
+    return readpipebuf(read_len)
 
 def writepipestr(linebytes):
     #print('LINE', linebytes)
-    os.write(writefd, struct.pack('I', len(linebytes)))
-    os.write(writefd, linebytes)
+    write_buffer.extend(struct.pack('I', len(linebytes)))
+    write_buffer.extend(linebytes)
+    if len(write_buffer) >= FLUSH_THRESHOLD:
+        flushpipe()
 
 def writepipebuf(linebytes):
     #print('BUF', linebytes)
-    os.write(writefd, linebytes)
+    write_buffer.extend(linebytes)
+    if len(write_buffer) >= FLUSH_THRESHOLD:
+        flushpipe()
+
+# Large arrays are placed in the shared-memory region when available; the pipe carries
+# [u8 tag][u32 length] (tag 1: data is in the region, tag 0: data follows inline).
+# HECL acknowledges with a single byte once it's done reading the region.
+BULK_THRESHOLD = 64 * 1024
+bulk_map = None
+
+def _ensurebulkmap(data_len):
+    global bulkfd, bulk_map
+    if bulk_map is not None and len(bulk_map) >= data_len:
+        return True
+    map_len = max(data_len, 2 * len(bulk_map) if bulk_map is not None else 0)
+    try:
+        os.ftruncate(bulkfd, map_len)
+        new_map = mmap.mmap(bulkfd, map_len)
+    except OSError:
+        # Region can't grow on this platform; send everything inline from now on
+        bulkfd = -1
+        return False
+    if bulk_map is not None:
+        bulk_map.close()
+    bulk_map = new_map
+    return True
+
+def writebulk(data):
+    view = memoryview(data).cast('B')
+    data_len = len(view)
+    if bulkfd >= 0 and data_len >= BULK_THRESHOLD and _ensurebulkmap(data_len):
+        bulk_map[0:data_len] = view
+        writepipebuf(struct.pack('=BI', 1, data_len))
+        readpipebuf(1)
+        return
+    writepipebuf(struct.pack('=BI', 0, data_len))
+    writepipebuf(view)
 
 def quitblender():
     writepipestr(b'QUITTING')
+    flushpipe()
     _quitblender()
 
 class PathHasher:
@@ -62,6 +133,7 @@ class PathHasher:
 # Ensure Blender 2.83+ is being used
 if bpy.app.version < (MIN_BLENDER_MAJOR, MIN_BLENDER_MINOR, 0):
     writepipestr(b'INVALIDBLENDERVER')
+    flushpipe()
     _quitblender()
 
 # If there's a third argument, use it as the .zip path containing the addon
@@ -82,11 +154,13 @@ try:
     import hecl
 except:
     writepipestr(b'NOADDON')
+    flushpipe()
     _quitblender()
 
 # Quit if just installed
 if did_install:
     writepipestr(b'ADDONINSTALLED')
+    flushpipe()
     _quitblender()
 
 # Intro handshake
@@ -132,7 +206,7 @@ def exec_compbuf(compbuf, globals):
 def animin_loop(globals):
     writepipestr(b'ANIMREADY')
     while True:
-        crv_type = struct.unpack('b', os.read(readfd, 1))
+        crv_type = struct.unpack('b', readpipebuf(1))
         if crv_type[0] < 0:
             writepipestr(b'ANIMDONE')
             return
@@ -143,19 +217,19 @@ def animin_loop(globals):
         elif crv_type[0] == 2:
             crvs = globals['scaleCurves']
 
-        key_info = struct.unpack('ii', os.read(readfd, 8))
+        key_info = struct.unpack('ii', readpipebuf(8))
         crv = crvs[key_info[0]]
         crv.keyframe_points.add(count=key_info[1])
 
         if crv_type[0] == 1:
             for k in range(key_info[1]):
-                key_data = struct.unpack('if', os.read(readfd, 8))
+                key_data = struct.unpack('if', readpipebuf(8))
                 pt = crv.keyframe_points[k]
                 pt.interpolation = 'LINEAR'
                 pt.co = (key_data[0], key_data[1])
         else:
             for k in range(key_info[1]):
-                key_data = struct.unpack('if', os.read(readfd, 8))
+                key_data = struct.unpack('if', readpipebuf(8))
                 pt = crv.keyframe_points[k]
                 pt.interpolation = 'LINEAR'
                 pt.co = (key_data[0], key_data[1])
@@ -246,7 +320,7 @@ def dataout_loop():
                 continue
 
             writepipestr(b'OK')
-            hecl.hmdl.cook(writepipebuf, bpy.data.objects[meshName])
+            hecl.hmdl.cook(writepipebuf, writebulk, bpy.data.objects[meshName])
 
         elif cmdargs[0] == 'ARMATURECOMPILE':
             armName = bpy.context.scene.hecl_arm_obj
@@ -266,7 +340,7 @@ def dataout_loop():
                 continue
 
             writepipestr(b'OK')
-            hecl.hmdl.cook(writepipebuf, bpy.data.objects[meshName], useLuv)
+            hecl.hmdl.cook(writepipebuf, writebulk, bpy.data.objects[meshName], useLuv)
 
         elif cmdargs[0] == 'MESHCOMPILENAMECOLLISION':
             meshName = cmdargs[1]
@@ -276,7 +350,7 @@ def dataout_loop():
                 continue
 
             writepipestr(b'OK')
-            hecl.hmdl.cookcol(writepipebuf, bpy.data.objects[meshName])
+            hecl.hmdl.cookcol(writepipebuf, writebulk, bpy.data.objects[meshName])
 
         elif cmdargs[0] == 'MESHCOMPILECOLLISIONALL':
             writepipestr(b'OK')
@@ -289,7 +363,7 @@ def dataout_loop():
 
             for obj in bpy.context.scene.objects:
                 if obj.type == 'MESH' and not obj.data.library:
-                    hecl.hmdl.cookcol(writepipebuf, obj)
+                    hecl.hmdl.cookcol(writepipebuf, writebulk, obj)
 
         elif cmdargs[0] == 'MESHCOMPILEPATH':
             meshName = bpy.context.scene.hecl_path_obj
@@ -562,9 +636,8 @@ try:
                     bracket_count += count_brackets(linestr)
 
                 except Exception as e:
-                    writepipestr(b'EXCEPTION')
+                    writepipestatus(traceback.format_exc().encode())
                     raise
-                    break
                 writepipestr(b'OK')
 
         elif cmdargs[0] == 'PYEND':
@@ -574,7 +647,7 @@ try:
             try:
                 dataout_loop()
             except Exception as e:
-                writepipestr(b'EXCEPTION')
+                writepipestatus(traceback.format_exc().encode())
                 raise
 
         elif cmdargs[0] == 'DATAEND':
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ToolBase.hpp"
+#include <algorithm>
+#include <csignal>
+#include <thread>
+#include "hecl/Blender/Pool.hpp"
+
+class ToolBlenderPool final : public ToolBase {
+  std::size_t m_shellCount = std::max(1u, std::thread::hardware_concurrency());
+  std::size_t m_maxRssMB = 4096;
+
+  static void StopHandler(int sig) { hecl::blender::PoolDaemon::Stop(); }
+
+public:
+  explicit ToolBlenderPool(const ToolPassInfo& info) : ToolBase(info) {
+    for (const hecl::SystemString& arg : info.args) {
+      if (arg.size() > 9 && !arg.compare(0, 9, _SYS_STR("--shells="))) {
+        m_shellCount = hecl::StrToUl(arg.c_str() + 9, nullptr, 0);
+        if (!m_shellCount)
+          LogModule.report(logvisor::Fatal, FMT_STRING(_SYS_STR("invalid shell count '{}'")), arg.c_str() + 9);
+      } else if (arg.size() > 10 && !arg.compare(0, 10, _SYS_STR("--max-rss="))) {
+        m_maxRssMB = hecl::StrToUl(arg.c_str() + 10, nullptr, 0);
+      } else {
+        LogModule.report(logvisor::Fatal, FMT_STRING(_SYS_STR("unrecognized argument '{}'")), arg);
+      }
+    }
+  }
+
+  static void Help(HelpOutput& help) {
+    help.secHead(_SYS_STR("NAME"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("hecl-blenderpool - Keep warm Blender instances for cooks to share\n"));
+    help.endWrap();
+
+    help.secHead(_SYS_STR("SYNOPSIS"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("hecl blenderpool [--shells=<count>] [--max-rss=<MiB>]\n"));
+    help.endWrap();
+
+    help.secHead(_SYS_STR("DESCRIPTION"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Runs in the foreground, keeping a set of Blender instances running between hecl ")
+                  _SYS_STR("invocations. While it runs, cooks lease these instances instead of launching their own, ")
+                      _SYS_STR("and are routed to an instance that already has the requested .blend loaded. ")
+                          _SYS_STR("Cooks fall back to launching a private Blender when every instance is busy. ")
+                              _SYS_STR("Interrupt to shut the pool down.\n"));
+    help.endWrap();
+
+    help.secHead(_SYS_STR("OPTIONS"));
+    help.optionHead(_SYS_STR("--shells=<count>"), _SYS_STR("pool size"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Number of Blender instances to keep running. Defaults to the CPU count, which matches ")
+                  _SYS_STR("the number of workers a cook uses.\n"));
+    help.endWrap();
+
+    help.optionHead(_SYS_STR("--max-rss=<MiB>"), _SYS_STR("memory limit"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Restarts an instance when it is returned to the pool with more than this much memory ")
+                  _SYS_STR("resident. Defaults to 4096; 0 disables the limit.\n"));
+    help.endWrap();
+  }
+
+  hecl::SystemStringView toolName() const override { return _SYS_STR("blenderpool"sv); }
+
+  int run() override {
+    hecl::blender::PoolDaemon daemon(m_shellCount, m_maxRssMB << 20);
+    signal(SIGINT, StopHandler);
+#ifndef _WIN32
+    signal(SIGTERM, StopHandler);
+#endif
+    return daemon.run();
+  }
+
+  void cancel() override { hecl::blender::PoolDaemon::Stop(); }
+};
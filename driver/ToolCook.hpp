@@ -1,8 +1,12 @@
 #pragma once
 
 #include "ToolBase.hpp"
+#include <chrono>
 #include <cstdio>
+#include <unordered_set>
 #include "hecl/ClientProcess.hpp"
+#include "hecl/CookDatabase.hpp"
+#include "hecl/ProjectWatcher.hpp"
 
 class ToolCook final : public ToolBase {
   std::vector<hecl::ProjectPath> m_selectedItems;
@@ -11,6 +15,88 @@ class ToolCook final : public ToolBase {
   const hecl::Database::DataSpecEntry* m_spec = nullptr;
   bool m_recursive = false;
   bool m_fast = false;
+  bool m_longestFirst = false;
+  bool m_watch = false;
+
+  /* Whether a changed path falls within what was selected for cooking */
+  bool isSelected(const hecl::ProjectPath& path, bool isDir) const {
+    const hecl::SystemStringView relPath = path.getRelativePath();
+    for (const hecl::ProjectPath& item : m_selectedItems) {
+      const hecl::SystemStringView itemPath = item.getRelativePath();
+      switch (item.getPathType()) {
+      case hecl::ProjectPath::Type::Glob: {
+        if (isDir)
+          break;
+        std::vector<hecl::ProjectPath> globResults;
+        item.getGlobResults(globResults);
+        if (std::find(globResults.begin(), globResults.end(), path) != globResults.end())
+          return true;
+        break;
+      }
+      case hecl::ProjectPath::Type::Directory:
+        if (itemPath == _SYS_STR(".")) {
+          if (m_recursive || path.getParentPath().getRelativePath() == _SYS_STR("."))
+            return true;
+          break;
+        }
+        if (relPath.size() <= itemPath.size() || relPath[itemPath.size()] != _SYS_STR('/') ||
+            !hecl::StringUtils::BeginsWith(relPath, itemPath))
+          break;
+        if (m_recursive || path.getParentPath() == item)
+          return true;
+        break;
+      default:
+        if (path == item)
+          return true;
+        break;
+      }
+    }
+    return false;
+  }
+
+  /* Recooks what changes, along with the sources depending on it, until interrupted. The
+   * ClientProcess stays up between passes so its workers keep their blender connections. */
+  int watch(hecl::ProjectWatcher& watcher, const hecl::MultiProgressPrinter& printer, hecl::ClientProcess& cp) {
+    hecl::Database::CookDatabase& cookDb = m_useProj->getCookDatabase();
+    LogModule.report(logvisor::Info, FMT_STRING(_SYS_STR("watching {} for changes")),
+                     m_useProj->getProjectRootPath().getAbsolutePath());
+
+    std::vector<hecl::ProjectPath> changed;
+    while (watcher.waitForChanges(changed, std::chrono::milliseconds(250))) {
+      std::unordered_set<uint64_t> queued;
+      auto queue = [&](const hecl::ProjectPath& path, bool recursive) {
+        if (queued.insert(path.hash().val64()).second)
+          m_useProj->cookPath(path, printer, recursive, false, m_fast, m_spec, &cp);
+      };
+
+      std::vector<hecl::ProjectPath> dependents;
+      for (const hecl::ProjectPath& path : changed) {
+        if (path.getRelativePath() == _SYS_STR(".")) {
+          /* Events were lost; let content comparison sort out what changed */
+          for (const hecl::ProjectPath& item : m_selectedItems)
+            queue(item, m_recursive);
+          continue;
+        }
+
+        /* Dependencies may be recorded as files or as directories containing them */
+        for (hecl::ProjectPath dep = path;; dep = dep.getParentPath()) {
+          cookDb.getDependents(dep, dependents);
+          if (dep.getParentPath().getRelativePath() == _SYS_STR("."))
+            break;
+        }
+
+        if (isSelected(path, path.isDirectory()))
+          queue(path, m_recursive);
+      }
+      for (const hecl::ProjectPath& dependent : dependents)
+        queue(dependent, false);
+
+      cp.waitUntilComplete();
+      cookDb.commit();
+      changed.clear();
+    }
+    return 1;
+  }
 
 public:
   explicit ToolCook(const ToolPassInfo& info) : ToolBase(info), m_useProj(info.project) {
@@ -29,6 +115,21 @@ public:
         else if (arg == _SYS_STR("--fast")) {
           m_fast = true;
           continue;
+        } else if (arg == _SYS_STR("--longest-first")) {
+          m_longestFirst = true;
+          continue;
+        } else if (arg == _SYS_STR("--watch")) {
+          m_watch = true;
+          continue;
+        } else if (arg == _SYS_STR("--topology=triangles")) {
+          hecl::blender::MeshTopologyOverride = hecl::HMDLTopology::Triangles;
+          continue;
+        } else if (arg == _SYS_STR("--topology=tristrips")) {
+          hecl::blender::MeshTopologyOverride = hecl::HMDLTopology::TriStrips;
+          continue;
+        } else if (arg == _SYS_STR("--pack-skin-banks")) {
+          hecl::blender::MeshSkinBankPacking = hecl::blender::SkinBankPacking::FirstFitDecreasing;
+          continue;
         } else if (arg.size() >= 8 && !arg.compare(0, 7, _SYS_STR("--spec="))) {
           hecl::SystemString specName(arg.begin() + 7, arg.end());
           for (const hecl::Database::DataSpecEntry* spec : hecl::Database::DATA_SPEC_REGISTRY) {
@@ -80,7 +181,8 @@ public:
 
     help.secHead(_SYS_STR("SYNOPSIS"));
     help.beginWrap();
-    help.wrap(_SYS_STR("hecl cook [-rf] [--fast] [--spec=<spec>] [<pathspec>...]\n"));
+    help.wrap(_SYS_STR("hecl cook [-rf] [--fast] [--longest-first] [--watch] [--topology=triangles|tristrips] ")
+                  _SYS_STR("[--pack-skin-banks] [--spec=<spec>] [<pathspec>...]\n"));
     help.endWrap();
 
     help.secHead(_SYS_STR("DESCRIPTION"));
@@ -97,11 +199,11 @@ public:
     help.wrap(_SYS_STR(" files return any linked "));
     help.wrapBold(_SYS_STR(".png"));
     help.wrap(_SYS_STR(" images). If the dependent files are unable to be found, the cook process aborts.\n\n"));
-    help.wrapBold(_SYS_STR("- Modtime Comparison: "));
-    help.wrap(_SYS_STR("Files that have previously finished a cook pass are inspected for their time of ")
-                  _SYS_STR("last modification. If the file hasn't changed since its previous cook-pass, the ") _SYS_STR(
-                      "process is skipped. If the file has been moved or deleted, the object is automatically ")
-                      _SYS_STR("removed from the project database.\n\n"));
+    help.wrapBold(_SYS_STR("- Content Comparison: "));
+    help.wrap(_SYS_STR("Files that have previously finished a cook pass are hashed along with their dependent ")
+                  _SYS_STR("files. If neither the file's contents, its dependencies' contents nor the DataSpec ")
+                      _SYS_STR("version have changed since its previous cook-pass, the process is skipped, ")
+                          _SYS_STR("regardless of file timestamps.\n\n"));
     help.wrapBold(_SYS_STR("- Cook: "));
     help.wrap(_SYS_STR("A type-specific procedure compiles the file's contents into an efficient format ")
                   _SYS_STR("for use by the runtime. A data-buffer is provided to HECL.\n\n"));
@@ -125,13 +227,40 @@ public:
     help.endWrap();
     help.optionHead(_SYS_STR("-f"), _SYS_STR("force"));
     help.beginWrap();
-    help.wrap(_SYS_STR("Forces cooking of all matched files, ignoring timestamp differences.\n"));
+    help.wrap(_SYS_STR("Forces cooking of all matched files, ignoring the record of previous cooks.\n"));
     help.endWrap();
     help.optionHead(_SYS_STR("--fast"), _SYS_STR("fast cook"));
     help.beginWrap();
     help.wrap(_SYS_STR("Performs draft-optimization cooking for supported data types.\n"));
     help.endWrap();
 
+    help.optionHead(_SYS_STR("--longest-first"), _SYS_STR("longest-first scheduling"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Starts the objects expected to take longest first, using the durations of previous cooks, ")
+                  _SYS_STR("so a few heavy objects don't leave the other workers idle at the end of a cook.\n"));
+    help.endWrap();
+
+    help.optionHead(_SYS_STR("--watch"), _SYS_STR("watch mode"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Keeps running after the cook, recooking files of the selection as they are saved, along ")
+                  _SYS_STR("with the objects that depend on them. Blender stays open between recooks. Only supported ")
+                      _SYS_STR("on Linux; interrupt to stop.\n"));
+    help.endWrap();
+
+    help.optionHead(_SYS_STR("--topology=triangles|tristrips"), _SYS_STR("mesh topology"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Overrides the primitive topology DataSpecs request for compiled meshes. Triangle lists are ")
+                  _SYS_STR("reordered for vertex cache efficiency and cook faster than strips. Run with -v to log ")
+                      _SYS_STR("the ACMR and ATVR of each mesh.\n"));
+    help.endWrap();
+
+    help.optionHead(_SYS_STR("--pack-skin-banks"), _SYS_STR("skin bank packing"));
+    help.beginWrap();
+    help.wrap(_SYS_STR("Packs the surfaces of skinned meshes into skin banks largest-first instead of in mesh order. ")
+                  _SYS_STR("This usually needs fewer banks, and so fewer draw calls at runtime, at the cost of ")
+                      _SYS_STR("bank assignments no longer matching earlier cooks.\n"));
+    help.endWrap();
+
     help.optionHead(_SYS_STR("--spec=<spec>"), _SYS_STR("data specification"));
     help.beginWrap();
     help.wrap(_SYS_STR("Specifies a DataSpec to use when cooking. ")
@@ -149,11 +278,25 @@ public:
 
   int run() override {
     hecl::MultiProgressPrinter printer(true);
+    hecl::StatCacheSession statCache;
+
+    /* Subscribe before the first pass so saves made during it are not missed */
+    std::unique_ptr<hecl::ProjectWatcher> watcher;
+    if (m_watch) {
+      watcher = std::make_unique<hecl::ProjectWatcher>(*m_useProj);
+      if (!*watcher) {
+        LogModule.report(logvisor::Error, FMT_STRING("--watch is not supported on this platform"));
+        return 1;
+      }
+    }
+
     hecl::ClientProcess cp(&printer);
+    cp.setLongestFirst(m_longestFirst);
     for (const hecl::ProjectPath& path : m_selectedItems)
       m_useProj->cookPath(path, printer, m_recursive, m_info.force, m_fast, m_spec, &cp);
     cp.waitUntilComplete();
-    return 0;
+    m_useProj->getCookDatabase().commit();
+    return watcher ? watch(*watcher, printer, cp) : 0;
   }
 
   void cancel() override { m_useProj->interruptCook(); }
@@ -60,6 +60,8 @@ public:
       helpFunc = ToolCook::Help;
     else if (toolName == _SYS_STR("package") || toolName == _SYS_STR("pack"))
       helpFunc = ToolPackage::Help;
+    else if (toolName == _SYS_STR("blenderpool"))
+      helpFunc = ToolBlenderPool::Help;
     else if (toolName == _SYS_STR("help"))
       helpFunc = ToolHelp::Help;
     else {
@@ -165,12 +165,14 @@ public:
 
     if (continuePrompt()) {
       hecl::MultiProgressPrinter printer(true);
+      hecl::StatCacheSession statCache;
       hecl::ClientProcess cp(&printer);
       for (const hecl::ProjectPath& path : m_selectedItems) {
         if (!m_useProj->packagePath(path, printer, m_fast, m_spec, &cp))
           LogModule.report(logvisor::Error, FMT_STRING(_SYS_STR("Unable to package {}")), path.getAbsolutePath());
       }
       cp.waitUntilComplete();
+      m_useProj->getCookDatabase().commit();
     }
 
     return 0;
@@ -29,6 +29,7 @@ logvisor::Module LogModule("hecl::Driver");
 #include "ToolPackage.hpp"
 #include "ToolImage.hpp"
 #include "ToolInstallAddon.hpp"
+#include "ToolBlenderPool.hpp"
 #include "ToolHelp.hpp"
 
 /* Static reference to dataspec additions
@@ -51,9 +52,9 @@ static void printHelp(const hecl::SystemChar* pname) {
   else
     fmt::print(FMT_STRING(_SYS_STR("HECL")));
 #if HECL_HAS_NOD
-#define TOOL_LIST "extract|init|cook|package|image|installaddon|help"
+#define TOOL_LIST "extract|init|cook|package|image|installaddon|blenderpool|help"
 #else
-#define TOOL_LIST "extract|init|cook|package|installaddon|help"
+#define TOOL_LIST "extract|init|cook|package|installaddon|blenderpool|help"
 #endif
 #if HECL_GIT
   fmt::print(FMT_STRING(_SYS_STR(" Commit " HECL_GIT_S " " HECL_BRANCH_S "\nUsage: {} " TOOL_LIST "\n")), pname);
@@ -257,6 +258,10 @@ static std::unique_ptr<ToolBase> MakeSelectedTool(hecl::SystemString toolName, T
     return std::make_unique<ToolInstallAddon>(info);
   }
 
+  if (toolNameLower == _SYS_STR("blenderpool")) {
+    return std::make_unique<ToolBlenderPool>(info);
+  }
+
   if (toolNameLower == _SYS_STR("help")) {
     return std::make_unique<ToolHelp>(info);
   }
@@ -29,6 +29,8 @@
 
 #include "hecl/hecl.hpp"
 #include "hecl/Backend.hpp"
+#include "hecl/BitVector.hpp"
+#include "hecl/Blender/Pool.hpp"
 #include "hecl/HMDLMeta.hpp"
 #include "hecl/TypedVariant.hpp"
 
@@ -288,6 +290,30 @@ struct Material {
   }
 };
 
+/**
+ * @brief Topology compiled meshes use in place of the one requested by the DataSpec
+ *
+ * Set for a whole cook (e.g. by `hecl cook --topology=`) to compare strip and
+ * triangle-list output without changing DataSpecs.
+ */
+extern std::optional<HMDLTopology> MeshTopologyOverride;
+
+/**
+ * @brief Strategy compiled meshes use to pack their surfaces into skin banks
+ */
+enum class SkinBankPacking {
+  FirstFit,          /**< Surfaces in mesh order, each into the first bank with room */
+  FirstFitDecreasing /**< Surfaces with the most distinct skins first; usually fewer banks */
+};
+
+/**
+ * @brief Skin bank packing used by compiled meshes, FirstFit unless set for the cook
+ *
+ * Each bank is bound as a separate skinning palette at runtime, so fewer banks means
+ * fewer draw calls.
+ */
+extern SkinBankPacking MeshSkinBankPacking;
+
 /** Intermediate mesh representation prepared by blender from a single mesh object */
 struct Mesh {
   static constexpr std::size_t MaxColorLayers = 4;
@@ -369,22 +395,60 @@ struct Mesh {
     struct Bank {
       std::vector<uint32_t> m_skinIdxs;
       std::vector<uint32_t> m_boneIdxs;
+      llvm::BitVector m_skinMask; /**< Set for each entry of m_skinIdxs */
+      llvm::BitVector m_boneMask; /**< Set for each entry of m_boneIdxs */
 
+      bool hasSkin(uint32_t skinIdx) const { return m_skinMask[skinIdx]; }
       void addSkins(const Mesh& parent, const std::vector<uint32_t>& skinIdxs);
     };
     std::vector<Bank> banks;
-    std::vector<Bank>::iterator addSkinBank(int skinSlotCount);
-    uint32_t addSurface(const Mesh& mesh, const Surface& surf, int skinSlotCount);
+    std::vector<Bank>::iterator addSkinBank(const Mesh& mesh, int skinSlotCount);
+
+    /** Places surf in a bank with room for its skins and sets iBankSkin of its verts
+     *  @return index of the bank */
+    uint32_t addSurface(const Mesh& mesh, Surface& surf, int skinSlotCount);
+
+    /** Places every surface of mesh and sets each skinBankIdx */
+    void addSurfaces(Mesh& mesh, int skinSlotCount, SkinBankPacking packing);
+
+  private:
+    llvm::BitVector m_gathered;
+    std::vector<uint32_t> m_skinSlots; /**< Slot of each skin in bank m_slotsBank */
+    uint32_t m_slotsBank = UINT32_MAX;
+    std::size_t m_slotsFilled = 0;
+    void _gatherSkins(const Mesh& mesh, const Surface& surf, std::vector<uint32_t>& skinsOut);
+    uint32_t _placeSurface(const Mesh& mesh, Surface& surf, const std::vector<uint32_t>& surfSkins, int skinSlotCount);
   } skinBanks;
 
   Mesh(Connection& conn, HMDLTopology topology, int skinSlotCount, bool useLuvs = false);
 
+  /** Positions and normals renumbered so each skin's verts are contiguous, with a table mapping
+   *  surface verts into them. References the mesh rather than copying it.
+   */
+  struct ContiguousSkinningView {
+    const Mesh& mesh;
+    std::vector<Vector3f> pos;
+    std::vector<Vector3f> norm;
+    std::vector<std::size_t> skinVertCounts; /**< Verts of each skin, in skin order */
+    std::vector<std::size_t> surfaceOffsets; /**< First vertIdxs entry of each surface */
+    std::vector<uint32_t> vertIdxs;          /**< New pos/norm index of each surface vert, UINT32_MAX if unskinned */
+
+    uint32_t getVertIdx(std::size_t surfIdx, std::size_t vertIdx) const {
+      return vertIdxs[surfaceOffsets[surfIdx] + vertIdx];
+    }
+  };
+  ContiguousSkinningView getContiguousSkinningView() const;
+
+  /** Copy of the mesh with getContiguousSkinningView() applied */
   Mesh getContiguousSkinningVersion() const;
 
   /** Prepares mesh representation for indexed access on modern APIs.
-   *  Mesh must remain resident for accessing reference members
+   *  Mesh must remain resident for accessing reference members.
+   *  packing selects the packed vertex attribute encodings to write, and ShortIndices
+   *  for 16-bit indices when the mesh has few enough verts.
    */
-  HMDLBuffers getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinIndex) const;
+  HMDLBuffers getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinIndex,
+                             HMDLFlags packing = HMDLFlags::None) const;
 };
 
 /** Intermediate collision mesh representation prepared by blender from a single mesh object */
@@ -444,7 +508,6 @@ struct ColMesh {
   struct Edge {
     std::array<uint32_t, 2> verts;
     bool seam;
-    Edge(Connection& conn);
   };
   std::vector<Edge> edges;
 
@@ -714,6 +777,7 @@ class Connection {
   friend struct Vector4f;
   friend struct World;
   friend class MeshOptimizer;
+  friend class PoolDaemon;
 
   std::atomic_bool m_lock = {false};
   bool m_pyStreamActive = false;
@@ -731,7 +795,45 @@ class Connection {
   BlendType m_loadedType = BlendType::None;
   bool m_loadedRigged = false;
   ProjectPath m_loadedBlend;
+  int64_t m_loadedModtime = 0;
+  uint64_t m_loadedSize = 0;
   hecl::SystemString m_errPath;
+
+  /* Shell leased from a PoolDaemon instead of launched by this connection */
+  std::unique_ptr<PoolClient> m_pool;
+  uint32_t m_poolShell = UINT32_MAX;
+  void _adoptLease(const PoolLease& lease);
+  void _returnLease();
+  PoolShellState _poolState() const;
+  bool _poolSwitch(const ProjectPath& path);
+  void _stampLoadedBlend();
+
+  /* Blender's output is a sequence of frames: [u32 length][payload], or a status frame
+   * [u32 StatusFrame][u32 length][message] reporting a Python exception. Frame payloads
+   * concatenate into the byte stream consumed by _readBuf. */
+  static constexpr uint32_t StatusFrame = 0xFFFFFFFF;
+  static constexpr std::size_t RecvBufferSize = 256 * 1024;
+  std::unique_ptr<uint8_t[]> m_recvBuffer;
+  std::size_t m_recvHead = 0;
+  std::size_t m_recvTail = 0;
+  uint32_t m_frameRemaining = 0;
+  bool _recvRaw(void* buf, std::size_t len);
+  bool _beginFrame();
+  void _resetRecv() { m_recvHead = m_recvTail = m_frameRemaining = 0; }
+
+  /* Shared-memory region blender may place large arrays in (see _beginBulk) */
+#ifndef _WIN32
+  int m_bulkFd = -1;
+  void* m_bulkMap = nullptr;
+  std::size_t m_bulkMapSz = 0;
+#endif
+  std::vector<uint8_t> m_bulkInline;
+  bool m_bulkAckPending = false;
+  void _createBulkRegion();
+  void _destroyBulkRegion();
+  const uint8_t* _beginBulk(std::size_t len);
+  void _endBulk();
+
   uint32_t _readStr(char* buf, uint32_t bufSz);
   uint32_t _writeStr(const char* str, uint32_t len, int wpipe);
   uint32_t _writeStr(const char* str, uint32_t len) { return _writeStr(str, len, m_writepipe[1]); }
@@ -813,10 +915,17 @@ class Connection {
   void _checkAnimReady(std::string_view action) { _checkStatus(action, "ANIMREADY"sv); }
   void _checkAnimDone(std::string_view action) { _checkStatus(action, "ANIMDONE"sv); }
   void _closePipe();
-  void _blenderDied();
+  void _blenderDied(std::string_view exception = {});
 
 public:
   Connection(int verbosityLevel = 1);
+  Connection(std::unique_ptr<PoolClient> pool, const PoolLease& lease);
+
+  /** Recorded blender output to replay without a blender process, for benchmarking the readers */
+  struct FromRecording {
+    int readFd;
+  };
+  explicit Connection(FromRecording recording);
   ~Connection();
 
   Connection(const Connection&) = delete;
@@ -935,4 +1044,17 @@ struct hash<array<hecl::blender::Mesh::SkinBind, 16>> {
     return h;
   }
 };
+template <>
+struct hash<hecl::blender::Mesh::Surface::Vert> {
+  std::size_t operator()(const hecl::blender::Mesh::Surface::Vert& val) const noexcept {
+    std::size_t h = val.iPos;
+    hecl::hash_combine_impl(h, std::size_t(val.iNorm));
+    for (uint32_t idx : val.iColor)
+      hecl::hash_combine_impl(h, std::size_t(idx));
+    for (uint32_t idx : val.iUv)
+      hecl::hash_combine_impl(h, std::size_t(idx));
+    hecl::hash_combine_impl(h, std::size_t(val.iSkin));
+    return h;
+  }
+};
 }
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "hecl/SystemChar.hpp"
+
+namespace hecl::blender {
+class Connection;
+
+/**
+ * @brief Blender-side state a pooled shell carries from one lease to the next
+ *
+ * The .blend stamp is taken when the file was opened (or last saved) so a lease holder
+ * can tell whether the copy resident in the shell is still current.
+ */
+struct PoolShellState {
+  uint64_t blendHash = 0; /**< ProjectPath::hash() of the loaded .blend, 0 if none */
+  int64_t blendModtime = 0;
+  uint64_t blendSize = 0;
+  uint32_t blendType = 0;
+  uint32_t blendRigged = 0;
+};
+
+/**
+ * @brief Pipe and shared-memory descriptors of a shell leased from the pool
+ */
+struct PoolLease {
+  uint32_t shell = UINT32_MAX;
+  int32_t pid = 0;
+  int readFd = -1;  /**< blender -> hecl */
+  int writeFd = -1; /**< hecl -> blender */
+  int bulkFd = -1;
+  PoolShellState state;
+  explicit operator bool() const { return shell != UINT32_MAX; }
+};
+
+/**
+ * @brief Client side of a running `hecl blenderpool` daemon
+ *
+ * Each Connection backed by the pool owns one client. Shells are handed over with
+ * SCM_RIGHTS; a shell must be idle (no python or data stream active) when returned.
+ */
+class PoolClient {
+  int m_sock;
+  explicit PoolClient(int sock) : m_sock(sock) {}
+
+public:
+  ~PoolClient();
+  PoolClient(const PoolClient&) = delete;
+  PoolClient& operator=(const PoolClient&) = delete;
+
+  /**
+   * @brief Connect to the daemon of the current user, if one is running
+   * @return nullptr if no daemon is listening
+   */
+  static std::unique_ptr<PoolClient> Connect();
+
+  /**
+   * @brief Lease a shell, preferring one that already has blendHash loaded
+   * @param blendHash hash of the .blend about to be opened, or 0 for any shell
+   * @param returnShell shell to give back in the same exchange, or UINT32_MAX
+   * @param returnState state of returnShell
+   * @return empty lease if every shell is busy or the daemon runs a different build
+   */
+  PoolLease acquire(uint64_t blendHash, uint32_t returnShell = UINT32_MAX, const PoolShellState& returnState = {});
+
+  /**
+   * @brief Give a leased shell back to the pool
+   */
+  void release(uint32_t shell, const PoolShellState& state);
+};
+
+/**
+ * @brief Daemon keeping a fixed number of warm blender shells for cook processes to lease
+ *
+ * Shells outlive the processes using them, so .blend files stay loaded across cooks; leases are
+ * routed to the shell that already has the requested .blend loaded. Shells whose resident set
+ * grows past the configured limit are restarted when they are returned, as are shells whose
+ * client disconnects while holding them.
+ */
+class PoolDaemon {
+  struct Shell {
+    std::unique_ptr<Connection> conn;
+    int client = -1;
+    PoolShellState state;
+    uint64_t lastUse = 0;
+  };
+  std::vector<Shell> m_shells;
+  std::vector<int> m_clients;
+  int m_listen = -1;
+  SystemString m_sockPath;
+  std::size_t m_maxRss;
+  uint64_t m_useCounter = 0;
+  static std::atomic_bool StopRequested;
+
+  void _spawnShell(Shell& shell);
+  void _killShell(Shell& shell);
+  void _returnShell(uint32_t idx, const PoolShellState& state);
+  uint32_t _selectShell(uint64_t blendHash, uint32_t returned) const;
+  bool _serviceClient(int client);
+  void _dropClient(int client);
+
+public:
+  /**
+   * @param shellCount number of blender shells to keep running
+   * @param maxRss resident set size in bytes past which a returned shell is restarted, 0 for no limit
+   */
+  PoolDaemon(std::size_t shellCount, std::size_t maxRss);
+  ~PoolDaemon();
+  PoolDaemon(const PoolDaemon&) = delete;
+  PoolDaemon& operator=(const PoolDaemon&) = delete;
+
+  /**
+   * @brief Serve leases until Stop() is called
+   * @return 0 on clean shutdown, 1 if the socket could not be bound
+   */
+  int run();
+
+  /**
+   * @brief Ask a running daemon to shut down; safe to call from a signal handler
+   */
+  static void Stop() { StopRequested = true; }
+};
+
+/**
+ * @brief Path of the unix socket the pool daemon of the current user listens on
+ */
+SystemString GetPoolSocketPath();
+
+} // namespace hecl::blender
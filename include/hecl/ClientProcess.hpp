@@ -1,12 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <functional>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "hecl/Blender/Token.hpp"
 #include "hecl/hecl.hpp"
@@ -24,14 +27,26 @@ class MultiProgressPrinter;
 extern int CpuCountOverride;
 void SetCpuCountOverride(int argc, const SystemChar** argv);
 
+/**
+ * @brief Pool of worker threads (each with its own Blender connection) for running transactions
+ *
+ * Every worker owns a deque of pending transactions. Transactions added from a worker
+ * thread go to that worker's deque; others are distributed round-robin. Idle workers
+ * steal from the back of other workers' deques before going to sleep.
+ *
+ * In longest-first mode, cook transactions are instead held in a shared queue ordered
+ * by expected duration. Workers take from it only once the deques (which then hold just
+ * lambda and buffer transactions, such as directory crawls) are empty, so discovery runs
+ * ahead of cooking and the whole cook is ordered rather than each discovery wave.
+ */
 class ClientProcess {
   std::mutex m_mutex;
   std::condition_variable m_cv;
   std::condition_variable m_initCv;
   std::condition_variable m_waitCv;
   const MultiProgressPrinter* m_progPrinter;
-  int m_completedCooks = 0;
-  int m_addedCooks = 0;
+  std::atomic_int m_completedCooks = 0;
+  std::atomic_int m_addedCooks = 0;
 
 public:
   struct Transaction {
@@ -68,10 +83,13 @@ public:
   };
 
 private:
-  std::list<std::shared_ptr<Transaction>> m_pendingQueue;
+  std::mutex m_completedMutex;
   std::list<std::shared_ptr<Transaction>> m_completedQueue;
-  int m_inProgress = 0;
-  bool m_running = true;
+  std::atomic_int m_pendingCount = 0;
+  std::atomic_int m_inProgress = 0;
+  std::atomic_int m_sleeping = 0;
+  std::atomic_uint m_nextWorker = 0;
+  std::atomic_bool m_running = true;
 
   struct Worker {
     ClientProcess& m_proc;
@@ -79,25 +97,61 @@ private:
     std::thread m_thr;
     blender::Token m_blendTok;
     bool m_didInit = false;
+    std::mutex m_queueMutex;
+    std::deque<std::shared_ptr<Transaction>> m_queue;
     Worker(ClientProcess& proc, int idx);
     void proc();
   };
-  std::vector<Worker> m_workers;
+  std::vector<std::unique_ptr<Worker>> m_workers;
   static ThreadLocalPtr<ClientProcess::Worker> ThreadWorker;
 
+  struct CostEntry {
+    uint32_t m_estimateMs;
+    uint64_t m_sequence;
+    std::shared_ptr<Transaction> m_trans;
+    /* Longest estimate first, then submission order */
+    bool operator<(const CostEntry& other) const {
+      if (m_estimateMs != other.m_estimateMs)
+        return m_estimateMs < other.m_estimateMs;
+      return m_sequence > other.m_sequence;
+    }
+  };
+  bool m_longestFirst = false;
+  std::mutex m_costMutex;
+  std::vector<CostEntry> m_costQueue;
+  uint64_t m_costSequence = 0;
+  std::atomic_int m_costQueueSize = 0;
+
+  Worker& selectWorker();
+  void enqueue(Worker& worker, std::shared_ptr<Transaction>&& trans);
+  void enqueueByCost(uint32_t estimateMs, std::shared_ptr<Transaction>&& trans);
+  void wakeWorkers(int count);
+  bool acquireTransaction(Worker& worker, std::shared_ptr<Transaction>& out);
+
 public:
   ClientProcess(const MultiProgressPrinter* progPrinter = nullptr);
   ~ClientProcess() { shutdown(); }
+
+  /**
+   * @brief Run pending cooks longest-first instead of in submission order
+   *
+   * Expected durations come from the cook database, falling back to IDataSpec::getCookCost().
+   * Must be set before any cook transactions are added.
+   */
+  void setLongestFirst(bool longestFirst) { m_longestFirst = longestFirst; }
   std::shared_ptr<const BufferTransaction> addBufferTransaction(const hecl::ProjectPath& path, void* target,
                                                                 size_t maxLen, size_t offset);
   std::shared_ptr<const CookTransaction> addCookTransaction(const hecl::ProjectPath& path, bool force, bool fast,
                                                             Database::IDataSpec* spec);
+  std::vector<std::shared_ptr<const CookTransaction>> addCookTransactions(const std::vector<hecl::ProjectPath>& paths,
+                                                                          bool force, bool fast,
+                                                                          Database::IDataSpec* spec);
   std::shared_ptr<const LambdaTransaction> addLambdaTransaction(std::function<void(blender::Token&)>&& func);
   bool syncCook(const hecl::ProjectPath& path, Database::IDataSpec* spec, blender::Token& btok, bool force, bool fast);
   void swapCompletedQueue(std::list<std::shared_ptr<Transaction>>& queue);
   void waitUntilComplete();
   void shutdown();
-  bool isBusy() const { return m_pendingQueue.size() || m_inProgress; }
+  bool isBusy() const { return m_pendingCount.load() || m_inProgress.load(); }
 
   static int GetThreadWorkerIdx() {
     Worker* w = ThreadWorker.get();
@@ -105,6 +159,14 @@ public:
       return w->m_idx;
     return -1;
   }
+  /** ClientProcess whose worker is running the calling thread, or null off its workers */
+  static ClientProcess* GetThreadClientProcess() {
+    Worker* w = ThreadWorker.get();
+    if (w)
+      return &w->m_proc;
+    return nullptr;
+  }
+  int getWorkerCount() const { return int(m_workers.size()); }
 };
 
 } // namespace hecl
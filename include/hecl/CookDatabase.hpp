@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hecl/hecl.hpp"
+
+namespace hecl::Database {
+class Project;
+
+/**
+ * @brief Persistent record of completed cooks, used for content-based incremental cooking
+ *
+ * One record is kept per (source path, cooked path) pair; the cooked path encodes the
+ * DataSpec (and draft flag) the source was cooked with. Each record stores the XXH64
+ * content hash of the source, the content hashes of every dependency the DataSpec reported,
+ * the DataSpec's cook version and hecl's own cook format version. A cook may be skipped only
+ * when all of these still match, regardless of how timestamps compare.
+ *
+ * The dependency lists discovered while building package depsgraphs are kept as well,
+ * so unchanged objects need not be re-queried (or re-opened in Blender) on the next build,
+ * along with the duration of each path's most recent cook for use by cook scheduling.
+ *
+ * File content hashes are memoized against (modtime, size) stamps so unchanged files
+ * are not re-read on every run. Records consulted during a run are also indexed by
+ * dependency, so watchers can find what to recook when a dependency changes. The database
+ * lives in .hecl/cookdb and is safe to query from multiple ClientProcess workers at once.
+ */
+class CookDatabase {
+public:
+  /**
+   * @brief Version of the cooked data hecl itself produces (HMDL buffers, MESHCOMPILE output, etc.)
+   *
+   * Bump whenever a change on the hecl side alters cooked bytes without a DataSpec change,
+   * so outputs cooked by an older hecl are recooked rather than reported up to date.
+   */
+  static constexpr uint32_t CookFormatVersion = 5;
+
+  struct Dependency {
+    std::string relPath;
+    Hash contentHash;
+  };
+
+  struct Record {
+    Hash contentHash;
+    uint32_t specVersion = 0;
+    uint32_t cookFormat = 0;
+    std::vector<Dependency> deps;
+  };
+
+  struct DepsRecord {
+    Hash contentHash;
+    std::vector<std::string> deps;
+  };
+
+private:
+  struct FileStamp {
+    time_t modtime = 0;
+    uint64_t size = 0;
+    Hash contentHash;
+  };
+
+  struct RecordKeyHash {
+    size_t operator()(const std::pair<uint64_t, uint64_t>& key) const noexcept {
+      return size_t(key.first ^ (key.second * 0x9E3779B97F4A7C15ULL));
+    }
+  };
+
+  Project& m_project;
+  SystemString m_dbPath;
+  mutable std::mutex m_lock;
+  std::unordered_map<uint64_t, FileStamp> m_stamps;
+  std::unordered_map<std::pair<uint64_t, uint64_t>, Record, RecordKeyHash> m_records;
+  std::unordered_map<uint64_t, DepsRecord> m_depsRecords;
+  std::unordered_map<uint64_t, uint32_t> m_cookDurations;
+  std::unordered_map<uint64_t, std::vector<ProjectPath>> m_dependents;
+  bool m_dirty = false;
+
+  Hash hashFile(const ProjectPath& path, SystemStringView absPath);
+  void indexDependents(const ProjectPath& path, const std::vector<ProjectPath>& deps);
+
+public:
+  CookDatabase(Project& project, const ProjectPath& dbPath);
+
+  /**
+   * @brief Read database from disk, discarding it if missing or of a different version
+   */
+  void load();
+
+  /**
+   * @brief Write database to disk if any records have changed since the last load/commit
+   * @return true on success
+   */
+  bool commit();
+
+  /**
+   * @brief Compute the content hash of a file, directory (first-level files) or glob
+   * @param path path to hash
+   * @return XXH64 content hash, or 0 if the path does not exist
+   */
+  Hash hashContents(const ProjectPath& path);
+
+  /**
+   * @brief Determine if a previous cook of path into cookedPath is still valid
+   * @param path source path about to be cooked
+   * @param cookedPath destination of the cook
+   * @param specVersion cook version reported by the DataSpec
+   * @param contentHashOut receives the current content hash of path for use with recordCook()
+   * @return true if the cooked object exists and source, dependencies and both versions match
+   */
+  bool isUpToDate(const ProjectPath& path, const ProjectPath& cookedPath, uint32_t specVersion,
+                  Hash& contentHashOut);
+
+  /**
+   * @brief Record a completed cook
+   * @param path source path that was cooked
+   * @param cookedPath destination of the cook
+   * @param specVersion cook version reported by the DataSpec
+   * @param contentHash content hash of path taken before the cook began
+   * @param deps additional source paths read by the cook
+   */
+  void recordCook(const ProjectPath& path, const ProjectPath& cookedPath, uint32_t specVersion, Hash contentHash,
+                  const std::vector<ProjectPath>& deps);
+
+  /**
+   * @brief Look up the dependencies gathered for path when it last had contentHash
+   * @param path path whose dependencies were gathered
+   * @param contentHash current content hash of path
+   * @param depsOut receives the recorded dependencies
+   * @return true if a record exists for path and its content hash matches
+   */
+  bool lookupDeps(const ProjectPath& path, Hash contentHash, std::vector<ProjectPath>& depsOut) const;
+
+  /**
+   * @brief Record the dependencies gathered for path at contentHash
+   * @return true if the record differs from the previously recorded one
+   */
+  bool recordDeps(const ProjectPath& path, Hash contentHash, const std::vector<ProjectPath>& deps);
+
+  /**
+   * @brief Collect the sources whose cooks read path
+   * @param path dependency to look up
+   * @param dependentsOut receives sources checked by isUpToDate() or recorded by recordCook() since load()
+   */
+  void getDependents(const ProjectPath& path, std::vector<ProjectPath>& dependentsOut) const;
+
+  /**
+   * @brief Look up how long the most recent cook of path took
+   * @param path source path that was cooked
+   * @param msOut receives the duration in milliseconds
+   * @return true if a duration has been recorded for path
+   */
+  bool lookupCookDuration(const ProjectPath& path, uint32_t& msOut) const;
+
+  /**
+   * @brief Record how long a cook of path took
+   */
+  void recordCookDuration(const ProjectPath& path, uint32_t ms);
+};
+
+} // namespace hecl::Database
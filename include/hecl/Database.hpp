@@ -1,14 +1,18 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "hecl/CookDatabase.hpp"
 #include "hecl/hecl.hpp"
 
 #include <logvisor/logvisor.hpp>
@@ -21,8 +25,13 @@ class Project;
 
 extern logvisor::Module LogModule;
 
+class ObjectBase;
+
 /**
  * @brief Nodegraph class for gathering dependency-resolved objects for packaging
+ *
+ * Each path is expanded once, at its first position in a depth-first walk from the root;
+ * later references to the same path are leaf nodes without a sub list.
  */
 class PackageDepsgraph {
 public:
@@ -30,19 +39,69 @@ public:
     enum class Type { Data, Group } type;
     ProjectPath path;
     ProjectPath cookedPath;
-    class ObjectBase* projectObj;
-    Node* sub;
-    Node* next;
+    class ObjectBase* projectObj = nullptr;
+    Node* sub = nullptr;
+    Node* next = nullptr;
+    Hash contentHash;
+    bool changed = false; /**< Node or one of its dependencies changed since the graph was last recorded */
   };
 
 private:
   friend class Project;
-  std::vector<Node> m_nodes;
+  std::deque<Node> m_nodes;
+  std::vector<std::unique_ptr<ObjectBase>> m_objects;
+
+  template <typename Func>
+  static void VisitLeavesFirst(const Node* node, std::unordered_set<uint64_t>& visited, bool changedOnly, Func& func) {
+    for (; node; node = node->next) {
+      if (changedOnly && !node->changed)
+        continue;
+      if (!visited.insert(node->path.hash().val64()).second)
+        continue;
+      VisitLeavesFirst(node->sub, visited, changedOnly, func);
+      func(*node);
+    }
+  }
 
 public:
-  const Node* getRootNode() const { return &m_nodes[0]; }
+  PackageDepsgraph();
+  ~PackageDepsgraph();
+  PackageDepsgraph(const PackageDepsgraph&) = delete;
+  PackageDepsgraph& operator=(const PackageDepsgraph&) = delete;
+  PackageDepsgraph(PackageDepsgraph&&) noexcept;
+  PackageDepsgraph& operator=(PackageDepsgraph&&) noexcept;
+
+  const Node* getRootNode() const { return m_nodes.empty() ? nullptr : &m_nodes[0]; }
+
+  /**
+   * @brief Visit each unique path of the graph once, dependencies before their dependents
+   * @param func callback receiving each node; suitable for scheduling leaf cooks first
+   */
+  template <typename Func>
+  void visitLeavesFirst(Func&& func) const {
+    std::unordered_set<uint64_t> visited;
+    VisitLeavesFirst(getRootNode(), visited, false, func);
+  }
+
+  /**
+   * @brief Like visitLeavesFirst(), but skips every subtree that has not changed
+   * @param func callback receiving each changed node
+   */
+  template <typename Func>
+  void visitChangedLeavesFirst(Func&& func) const {
+    std::unordered_set<uint64_t> visited;
+    VisitLeavesFirst(getRootNode(), visited, true, func);
+  }
 };
 
+/**
+ * @brief A rough description of how 'expensive' a given cook operation is
+ *
+ * This is used to provide pretty colors during the cook operation and, when no
+ * duration has been recorded for a path yet, to order longest-first cook scheduling
+ */
+enum class CookCost { None, Light, Medium, Heavy };
+
 /**
  * @brief Subclassed by dataspec entries to manage per-game aspects of the data pipeline
  *
@@ -103,6 +162,39 @@ public:
                       [[maybe_unused]] bool fast, [[maybe_unused]] blender::Token& btok,
                       [[maybe_unused]] FCookProgress progress) {}
 
+  /**
+   * @brief Version of the cooked formats emitted by this DataSpec
+   *
+   * Stored with each cook in the project's cook database; bumping this
+   * invalidates every object previously cooked with this DataSpec.
+   */
+  virtual uint32_t getCookVersion() const { return 0; }
+
+  /**
+   * @brief Estimate how expensive cooking path will be
+   *
+   * Only consulted for scheduling when the cook database has no recorded duration for path.
+   */
+  virtual CookCost getCookCost([[maybe_unused]] const ProjectPath& path) const { return CookCost::Medium; }
+
+  /**
+   * @brief Report additional source files read by the preceding doCook() of path
+   *
+   * Called on the cooking thread directly after doCook() returns. Changing the
+   * contents of any reported dependency causes path to be recooked.
+   */
+  virtual void getCookDependencies([[maybe_unused]] const ProjectPath& path,
+                                   [[maybe_unused]] std::vector<ProjectPath>& depsOut) {}
+
+  /**
+   * @brief Construct the project object representing path for dependency gathering
+   * @param path working path to represent
+   * @return new object, or nullptr if path has no object representation in this DataSpec
+   *
+   * Called from ClientProcess workers while building a PackageDepsgraph.
+   */
+  virtual std::unique_ptr<ObjectBase> buildProjectObject(const ProjectPath& path);
+
   virtual bool canPackage([[maybe_unused]] const ProjectPath& path) {
     return false;
   }
@@ -234,14 +326,19 @@ private:
   ProjectPath m_workRoot;
   ProjectPath m_dotPath;
   ProjectPath m_cookedRoot;
+  CookDatabase m_cookDatabase;
   std::vector<ProjectDataSpec> m_compiledSpecs;
   std::unordered_map<uint64_t, ProjectPath> m_bridgePathCache;
   std::vector<std::unique_ptr<IDataSpec>> m_cookSpecs;
   std::unique_ptr<IDataSpec> m_lastPackageSpec;
+  std::atomic_bool m_packageInterrupted = false;
   bool m_valid = false;
 
+  const DataSpecEntry* selectPackageSpec(const DataSpecEntry* spec) const;
+
 public:
   Project(const ProjectRootPath& rootPath);
+  ~Project();
   explicit operator bool() const { return m_valid; }
 
   /**
@@ -270,10 +367,8 @@ public:
 
   /**
    * @brief A rough description of how 'expensive' a given cook operation is
-   *
-   * This is used to provide pretty colors during the cook operation
    */
-  enum class Cost { None, Light, Medium, Heavy };
+  using Cost = CookCost;
 
   /**
    * @brief Get the path of the project's root-directory
@@ -298,6 +393,15 @@ public:
    */
   const ProjectPath& getProjectCookedPath(const DataSpecEntry& spec) const;
 
+  /**
+   * @brief Get the database of completed cooks used to skip unchanged objects
+   * @return project cook database
+   *
+   * Records are committed to disk when the project is destroyed; long-running
+   * users should call CookDatabase::commit() after each cook pass.
+   */
+  CookDatabase& getCookDatabase() { return m_cookDatabase; }
+
   /**
    * @brief Add given file(s) to the database
    * @param paths files or patterns within project
@@ -394,6 +498,9 @@ public:
    * @param fast enables faster (draft) extraction for supported data types
    * @param spec if non-null, cook using a manually-selected dataspec
    * @param cp if non-null, cook asynchronously via the ClientProcess
+   *
+   * The package depsgraph is built first and the changed parts of it are cooked
+   * dependencies-first; subtrees unchanged since the last package are skipped.
    */
   bool packagePath(const ProjectPath& path, const MultiProgressPrinter& feedbackCb, bool fast = false,
                    const DataSpecEntry* spec = nullptr, ClientProcess* cp = nullptr);
@@ -424,9 +531,26 @@ public:
   /**
    * @brief Constructs a full depsgraph of the project-subpath provided
    * @param path Subpath of project to root depsgraph at
+   * @param spec if non-null, gather project objects using a manually-selected dataspec
+   * @param cp if non-null, gather dependencies in parallel via the ClientProcess
    * @return Populated depsgraph ready to traverse
+   *
+   * Dependencies are gathered through ObjectBase::gatherDeps() and, for .blend files,
+   * the textures they reference. Nodes are flagged changed when their content or their
+   * dependency (or directory child) list differs from the last recordPackageDepsgraph().
+   * When cp is provided, this waits for all of its pending transactions to complete.
+   */
+  PackageDepsgraph buildPackageDepsgraph(const ProjectPath& path, const DataSpecEntry* spec = nullptr,
+                                         ClientProcess* cp = nullptr);
+
+  /**
+   * @brief Store the dependency lists of a depsgraph in the cook database
+   * @param graph depsgraph whose contents have been successfully packaged
+   *
+   * Subsequent builds treat the recorded nodes as unchanged until their content or
+   * dependencies change, and don't re-open unchanged .blend files to gather textures.
    */
-  PackageDepsgraph buildPackageDepsgraph(const ProjectPath& path);
+  void recordPackageDepsgraph(const PackageDepsgraph& graph);
 
   /** Add ProjectPath to bridge cache */
   void addBridgePathToCache(uint64_t id, const ProjectPath& path);
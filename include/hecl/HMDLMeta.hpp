@@ -1,6 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 #include <athena/DNA.hpp>
+#include <athena/Types.hpp>
 
 namespace hecl {
 
@@ -9,11 +14,38 @@ enum class HMDLTopology : atUint32 {
   TriStrips,
 };
 
-#define HECL_HMDL_META_SZ 32
+/**
+ * @brief Optional packed encodings of HMDL vertex attributes and indices
+ *
+ * Each packed attribute keeps 4-byte alignment; unset flags leave the attribute as 32-bit floats
+ * and indices as 32-bit. ShortIndices only affects cooked storage; HMDLData widens indices to
+ * 32-bit on load.
+ */
+enum class HMDLFlags : atUint32 {
+  None = 0,
+  PackedPositions = 1 << 0, /**< UNorm16 xyz within posMin/posScale, 2 bytes padding */
+  OctNormals = 1 << 1,      /**< SNorm16 octahedral-encoded normal */
+  HalfUVs = 1 << 2,         /**< Half-float UVs */
+  PackedWeights = 1 << 3,   /**< UNorm8 weights, one byte per bone slot */
+  VertexPackingMask = PackedPositions | OctNormals | HalfUVs | PackedWeights,
+  ShortIndices = 1 << 4, /**< 16-bit indices with 0xffff as primitive restart */
+};
+ENABLE_BITWISE_ENUM(HMDLFlags)
+
+/**
+ * @brief Layout version of HMDLMeta and the buffers it describes
+ *
+ * Bump whenever a field or an encoding changes. Version 1 is the 32-byte float-only layout,
+ * which has no version field; its topology (0 or 1) reads back as the version.
+ */
+constexpr atUint32 HMDLMetaVersion = 2;
+
+#define HECL_HMDL_META_SZ 64
 
 struct HMDLMeta : athena::io::DNA<athena::Endian::Big> {
   AT_DECL_DNA
   Value<atUint32> magic = 'TACO';
+  Value<atUint32> version = HMDLMetaVersion;
   Value<HMDLTopology> topology;
   Value<atUint32> vertStride;
   Value<atUint32> vertCount;
@@ -22,6 +54,112 @@ struct HMDLMeta : athena::io::DNA<athena::Endian::Big> {
   Value<atUint32> uvCount;
   Value<atUint16> weightCount;
   Value<atUint16> bankCount;
+  Value<HMDLFlags> flags = HMDLFlags::None;
+  Value<atVec3f> posMin;   /**< Position of UNorm16 0 with PackedPositions */
+  Value<atVec3f> posScale; /**< Position extent covered by UNorm16 0-65535 with PackedPositions */
 };
 
+/**
+ * @brief Size of one vertex in the layout described by an HMDLMeta
+ */
+constexpr atUint32 HMDLVertStride(HMDLFlags flags, atUint32 colorCount, atUint32 uvCount, atUint32 weightCount) {
+  return (True(flags & HMDLFlags::PackedPositions) ? 8 : 12) + (True(flags & HMDLFlags::OctNormals) ? 4 : 12) +
+         colorCount * 4 + uvCount * (True(flags & HMDLFlags::HalfUVs) ? 4 : 8) +
+         weightCount * (True(flags & HMDLFlags::PackedWeights) ? 4 : 16);
+}
+
+/**
+ * @brief Round float to the nearest IEEE 754 half-precision value
+ */
+inline atUint16 FloatToHalf(float val) {
+  atUint32 f;
+  std::memcpy(&f, &val, 4);
+  const atUint32 sign = (f >> 16) & 0x8000;
+  const atUint32 fexp = (f >> 23) & 0xff;
+  atUint32 mant = f & 0x7fffff;
+  if (fexp == 0xff)
+    return atUint16(sign | 0x7c00 | (mant ? 0x200 : 0));
+  const atInt32 exp = atInt32(fexp) - 127 + 15;
+  if (exp >= 31)
+    return atUint16(sign | 0x7c00);
+  if (exp <= 0) {
+    /* Subnormal half */
+    if (exp < -10)
+      return atUint16(sign);
+    mant |= 0x800000;
+    const atUint32 shift = atUint32(14 - exp);
+    atUint32 h = mant >> shift;
+    if ((mant >> (shift - 1)) & 1)
+      ++h;
+    return atUint16(sign | h);
+  }
+  /* Rounding may carry into the exponent, which is still the correctly rounded result */
+  atUint32 h = sign | (atUint32(exp) << 10) | (mant >> 13);
+  if (mant & 0x1000)
+    ++h;
+  return atUint16(h);
+}
+
+/**
+ * @brief Expand an IEEE 754 half-precision value
+ */
+inline float HalfToFloat(atUint16 val) {
+  const atUint32 sign = atUint32(val & 0x8000) << 16;
+  atUint32 exp = (val >> 10) & 0x1f;
+  atUint32 mant = val & 0x3ff;
+  atUint32 f;
+  if (exp == 0) {
+    if (mant == 0) {
+      f = sign;
+    } else {
+      exp = 113;
+      while (!(mant & 0x400)) {
+        mant <<= 1;
+        --exp;
+      }
+      f = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+  } else if (exp == 31) {
+    f = sign | 0x7f800000 | (mant << 13);
+  } else {
+    f = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float ret;
+  std::memcpy(&ret, &f, 4);
+  return ret;
+}
+
+/**
+ * @brief Encode a unit normal as two SNorm16 octahedral coordinates
+ */
+inline void OctEncodeNormal(const float n[3], atInt16 out[2]) {
+  const float l1 = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+  float x = l1 > 0.f ? n[0] / l1 : 0.f;
+  float y = l1 > 0.f ? n[1] / l1 : 0.f;
+  if (n[2] < 0.f) {
+    /* Fold the lower hemisphere over the diagonals */
+    const float ox = x;
+    x = (1.f - std::fabs(y)) * (ox >= 0.f ? 1.f : -1.f);
+    y = (1.f - std::fabs(ox)) * (y >= 0.f ? 1.f : -1.f);
+  }
+  out[0] = atInt16(std::lround(std::clamp(x, -1.f, 1.f) * 32767.f));
+  out[1] = atInt16(std::lround(std::clamp(y, -1.f, 1.f) * 32767.f));
+}
+
+/**
+ * @brief Decode two SNorm16 octahedral coordinates into a unit normal
+ */
+inline void OctDecodeNormal(const atInt16 in[2], float n[3]) {
+  float x = std::max(in[0] / 32767.f, -1.f);
+  float y = std::max(in[1] / 32767.f, -1.f);
+  const float z = 1.f - std::fabs(x) - std::fabs(y);
+  const float t = std::max(-z, 0.f);
+  x += x >= 0.f ? -t : t;
+  y += y >= 0.f ? -t : t;
+  const float len = std::sqrt(x * x + y * y + z * z);
+  n[0] = x / len;
+  n[1] = y / len;
+  n[2] = z / len;
+}
+
 } // namespace hecl
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+#include "hecl/hecl.hpp"
+
+namespace hecl {
+
+/**
+ * @brief Reports changes within a project working tree, for incremental recooks
+ *
+ * Backed by inotify, so the watcher is only valid on Linux. Every non-hidden directory under
+ * the project root is watched (which leaves out .hecl/), including directories created while
+ * watching. Changed paths have their cached metadata invalidated before they are reported.
+ */
+class ProjectWatcher {
+  Database::Project& m_project;
+  int m_fd = -1;
+  std::unordered_map<int, ProjectPath> m_watches;
+
+  void _addWatches(const ProjectPath& dir);
+  bool _readEvents(std::vector<ProjectPath>& changedOut, bool& structuralOut);
+
+public:
+  explicit ProjectWatcher(Database::Project& project);
+  ~ProjectWatcher();
+  ProjectWatcher(const ProjectWatcher&) = delete;
+  ProjectWatcher& operator=(const ProjectWatcher&) = delete;
+
+  explicit operator bool() const { return m_fd >= 0; }
+
+  /**
+   * @brief Block until something changes, then gather changes until the tree has been quiet for debounce
+   * @param changedOut receives each changed file or directory once; a lost event queue reports the project root
+   * @param debounce quiet period ending a batch of changes
+   * @return false if the watcher failed
+   */
+  bool waitForChanges(std::vector<ProjectPath>& changedOut, std::chrono::milliseconds debounce);
+};
+
+} // namespace hecl
@@ -28,11 +28,13 @@ extern "C" int rep_closefrom(int lower);
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cinttypes>
 #include <cstdarg>
 #include <cstdio>
 #include <ctime>
 #include <functional>
+#include <iterator>
 #include <list>
 #include <map>
 #include <regex>
@@ -523,6 +525,9 @@ struct CaseInsensitiveCompare {
 
 /**
  * @brief Directory traversal tool for accessing sorted directory entries
+ *
+ * Only regular files and directories are listed. Where the OS reports entry types
+ * while reading the directory, entries are not stat'ed unless sizeSort is set.
  */
 class DirectoryEnumerator {
 public:
@@ -530,7 +535,7 @@ public:
   struct Entry {
     hecl::SystemString m_path;
     hecl::SystemString m_name;
-    size_t m_fileSz;
+    size_t m_fileSz; /**< Only filled in for sizeSort enumerations on POSIX systems */
     bool m_isDir;
 
     Entry(hecl::SystemString path, const hecl::SystemChar* name, size_t sz, bool isDir)
@@ -550,6 +555,65 @@ public:
   std::vector<Entry>::const_iterator end() const { return m_entries.cend(); }
 };
 
+/**
+ * @brief Lazily reads directory entries in native order without buffering them
+ *
+ * Yields the same entries as DirectoryEnumerator::Mode::Native (with m_fileSz left 0 on
+ * POSIX systems). The entry an iterator refers to is overwritten when it is advanced.
+ */
+class DirectoryStream {
+public:
+  using Entry = DirectoryEnumerator::Entry;
+
+  class Iterator {
+    DirectoryStream* m_stream;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Entry*;
+    using reference = const Entry&;
+
+    explicit Iterator(DirectoryStream* stream) : m_stream(stream) {}
+    reference operator*() const { return m_stream->m_entry; }
+    pointer operator->() const { return &m_stream->m_entry; }
+    Iterator& operator++() {
+      if (!m_stream->next())
+        m_stream = nullptr;
+      return *this;
+    }
+    bool operator==(const Iterator& other) const { return m_stream == other.m_stream; }
+    bool operator!=(const Iterator& other) const { return m_stream != other.m_stream; }
+  };
+
+private:
+  SystemString m_path;
+#if _WIN32
+  HANDLE m_handle;
+  WIN32_FIND_DATAW m_findData;
+  bool m_pending;
+#else
+  void* m_handle;
+#endif
+  Entry m_entry{{}, _SYS_STR(""), 0, false};
+  bool m_noHidden;
+
+  bool next();
+
+public:
+  explicit DirectoryStream(SystemStringView path, bool noHidden = false);
+  ~DirectoryStream();
+  DirectoryStream(const DirectoryStream&) = delete;
+  DirectoryStream& operator=(const DirectoryStream&) = delete;
+
+  /**
+   * @brief Read the first entry; a stream may only be iterated once
+   */
+  Iterator begin() { return ++Iterator(this); }
+  Iterator end() { return Iterator(nullptr); }
+};
+
 /**
  * @brief Build list of common OS-specific directories
  */
@@ -658,32 +722,41 @@ public:
  * NOTE THAT PROJECT PATHS ARE TREATED AS CASE SENSITIVE!!
  */
 class ProjectPath {
-  Database::Project* m_proj = nullptr;
-  SystemString m_absPath;
-  SystemString m_relPath;
-  SystemString m_auxInfo;
-  Hash m_hash = 0;
-#if HECL_UCS2
-  std::string m_utf8AbsPath;
-  std::string m_utf8RelPath;
-  std::string m_utf8AuxInfo;
-#endif
-  void ComputeHash() {
+public:
+  /**
+   * @brief Canonical strings of one project path, shared by every ProjectPath naming it
+   *
+   * Entries are interned process-wide by hash and never freed, so the views stay valid
+   * (and NUL-terminated) for the lifetime of the process.
+   */
+  struct Interned {
+    SystemStringView absPath;
+    SystemStringView relPath;
+    SystemStringView auxInfo;
 #if HECL_UCS2
-    m_utf8AbsPath = WideToUTF8(m_absPath);
-    m_utf8RelPath = WideToUTF8(m_relPath);
-    m_utf8AuxInfo = WideToUTF8(m_auxInfo);
-    if (m_utf8AuxInfo.size())
-      m_hash = Hash(m_utf8RelPath + '|' + m_utf8AuxInfo);
-    else
-      m_hash = Hash(m_utf8RelPath);
-#else
-    if (m_auxInfo.size())
-      m_hash = Hash(m_relPath + '|' + m_auxInfo);
-    else
-      m_hash = Hash(m_relPath);
+    std::string_view utf8AbsPath;
+    std::string_view utf8RelPath;
+    std::string_view utf8AuxInfo;
 #endif
-  }
+    Hash hash = 0;     /**< Hash of relPath and auxInfo */
+    Hash rootHash = 0; /**< Hash of the project root absPath resolves against */
+
+    /* Filesystem metadata, valid while the epoch matches that of the open StatCacheSession */
+    mutable std::atomic<uint64_t> statEpoch = 0;
+    mutable std::atomic<uint64_t> modtimeEpoch = 0;
+    mutable std::atomic<uint8_t> statType = 0;
+    mutable std::atomic<int64_t> statModtime = 0;
+    mutable std::atomic<int64_t> modtime = 0;
+
+    static const Interned Empty;
+  };
+
+private:
+  Database::Project* m_proj = nullptr;
+  const Interned* m_path = &Interned::Empty;
+
+  void assignCanon(Database::Project& project, SystemString&& relPath, SystemStringView auxInfo);
+  static std::pair<SystemStringView, SystemStringView> SplitAuxInfo(SystemStringView path);
 
 public:
   /**
@@ -696,20 +769,14 @@ public:
   /**
    * @brief Tests for non-empty project path
    */
-  explicit operator bool() const { return m_absPath.size() != 0; }
+  explicit operator bool() const { return !m_path->absPath.empty(); }
 
   /**
    * @brief Clears path
    */
   void clear() {
     m_proj = nullptr;
-    m_absPath.clear();
-    m_relPath.clear();
-    m_hash = 0;
-#if HECL_UCS2
-    m_utf8AbsPath.clear();
-    m_utf8RelPath.clear();
-#endif
+    m_path = &Interned::Empty;
   }
 
   /**
@@ -742,7 +809,7 @@ public:
    * @brief Determine if ProjectPath represents project root directory
    * @return true if project root directory
    */
-  bool isRoot() const { return m_relPath.empty(); }
+  bool isRoot() const { return m_path->relPath.empty(); }
 
   /**
    * @brief Return new ProjectPath with extension added
@@ -756,17 +823,16 @@ public:
    * @brief Access fully-canonicalized absolute path
    * @return Absolute path reference
    */
-  SystemStringView getAbsolutePath() const { return m_absPath; }
+  SystemStringView getAbsolutePath() const { return m_path->absPath; }
 
   /**
    * @brief Access fully-canonicalized project-relative path
    * @return Relative pointer to within absolute-path or "." for project root-directory (use isRoot to detect)
    */
   SystemStringView getRelativePath() const {
-    if (m_relPath.size())
-      return m_relPath;
-    static const SystemString dot = _SYS_STR(".");
-    return dot;
+    if (m_path->relPath.size())
+      return m_path->relPath;
+    return _SYS_STR(".");
   }
 
   /**
@@ -783,12 +849,13 @@ public:
    * This will not resolve outside the project root (error in that case)
    */
   ProjectPath getParentPath() const {
-    if (m_relPath == _SYS_STR("."))
+    const SystemStringView relPath = m_path->relPath;
+    if (relPath == _SYS_STR("."))
       LogModule.report(logvisor::Fatal, FMT_STRING("attempted to resolve parent of root project path"));
-    size_t pos = m_relPath.rfind(_SYS_STR('/'));
-    if (pos == SystemString::npos)
+    size_t pos = relPath.rfind(_SYS_STR('/'));
+    if (pos == SystemStringView::npos)
       return ProjectPath(*m_proj, _SYS_STR(""));
-    return ProjectPath(*m_proj, SystemString(m_relPath.begin(), m_relPath.begin() + pos));
+    return ProjectPath(*m_proj, relPath.substr(0, pos));
   }
 
   /**
@@ -796,22 +863,18 @@ public:
    * @return Final component c-string (may be empty)
    */
   SystemStringView getLastComponent() const {
-    size_t pos = m_relPath.rfind(_SYS_STR('/'));
-    if (pos == SystemString::npos)
-      return m_relPath;
-    return {m_relPath.c_str() + pos + 1, m_relPath.size() - pos - 1};
+    const SystemStringView relPath = m_path->relPath;
+    size_t pos = relPath.rfind(_SYS_STR('/'));
+    if (pos == SystemStringView::npos)
+      return relPath;
+    return relPath.substr(pos + 1);
   }
   std::string_view getLastComponentUTF8() const {
-    size_t pos = m_relPath.rfind(_SYS_STR('/'));
-#if HECL_UCS2
-    if (pos == SystemString::npos)
-      return m_utf8RelPath;
-    return {m_utf8RelPath.c_str() + pos + 1, size_t(m_utf8RelPath.size() - pos - 1)};
-#else
-    if (pos == SystemString::npos)
-      return m_relPath;
-    return {m_relPath.c_str() + pos + 1, size_t(m_relPath.size() - pos - 1)};
-#endif
+    const std::string_view relPath = getRelativePathUTF8();
+    size_t pos = relPath.rfind('/');
+    if (pos == std::string_view::npos)
+      return relPath;
+    return relPath.substr(pos + 1);
   }
 
   /**
@@ -835,16 +898,17 @@ public:
    * @return Vector of path components
    */
   std::vector<hecl::SystemString> getPathComponents() const {
+    const SystemStringView relPath = m_path->relPath;
     std::vector<hecl::SystemString> ret;
-    if (m_relPath.empty())
+    if (relPath.empty())
       return ret;
-    auto it = m_relPath.cbegin();
+    auto it = relPath.cbegin();
     if (*it == _SYS_STR('/')) {
       ret.push_back(_SYS_STR("/"));
       ++it;
     }
     hecl::SystemString comp;
-    for (; it != m_relPath.cend(); ++it) {
+    for (; it != relPath.cend(); ++it) {
       if (*it == _SYS_STR('/')) {
         if (comp.empty())
           continue;
@@ -864,11 +928,7 @@ public:
    * @return Vector of path components encoded as UTF8
    */
   std::vector<std::string> getPathComponentsUTF8() const {
-#if HECL_UCS2
-    const std::string& relPath = m_utf8RelPath;
-#else
-    const std::string& relPath = m_relPath;
-#endif
+    const std::string_view relPath = getRelativePathUTF8();
     std::vector<std::string> ret;
     if (relPath.empty())
       return ret;
@@ -899,27 +959,27 @@ public:
    */
   std::string_view getAbsolutePathUTF8() const {
 #if HECL_UCS2
-    return m_utf8AbsPath;
+    return m_path->utf8AbsPath;
 #else
-    return m_absPath;
+    return m_path->absPath;
 #endif
   }
 
   std::string_view getRelativePathUTF8() const {
 #if HECL_UCS2
-    return m_utf8RelPath;
+    return m_path->utf8RelPath;
 #else
-    return m_relPath;
+    return m_path->relPath;
 #endif
   }
 
-  SystemStringView getAuxInfo() const { return m_auxInfo; }
+  SystemStringView getAuxInfo() const { return m_path->auxInfo; }
 
   std::string_view getAuxInfoUTF8() const {
 #if HECL_UCS2
-    return m_utf8AuxInfo;
+    return m_path->utf8AuxInfo;
 #else
-    return m_auxInfo;
+    return m_path->auxInfo;
 #endif
   }
 
@@ -983,9 +1043,19 @@ public:
   /**
    * @brief Get type of path based on syntax and filesystem queries
    * @return Type of path
+   *
+   * Answered from the stat cache while a StatCacheSession is open
    */
   Type getPathType() const;
 
+  /**
+   * @brief Drop cached metadata of this path after writing to it within a StatCacheSession
+   */
+  void invalidateStat() const {
+    m_path->statEpoch = 0;
+    m_path->modtimeEpoch = 0;
+  }
+
   /**
    * @brief Test if nothing exists at path
    * @return True if nothing exists at path
@@ -1020,6 +1090,8 @@ public:
    * Regular files simply return their modtime as queried from the OS
    * Directories return the latest modtime of all first-level regular files
    * Glob-paths return the latest modtime of all matched regular files
+   *
+   * Answered from the stat cache while a StatCacheSession is open
    */
   Time getModtime() const;
 
@@ -1037,6 +1109,10 @@ public:
   /**
    * @brief Insert glob matches into existing vector
    * @param outPaths Vector to add matches to (will not erase existing contents)
+   *
+   * Components containing '*' are matched fnmatch-style ('*' and '[...]') against
+   * non-hidden entries; only regular files are matched by the final component.
+   * The expansion is computed once per StatCacheSession epoch.
    */
   void getGlobResults(std::vector<ProjectPath>& outPaths) const;
 
@@ -1046,7 +1122,7 @@ public:
    */
   size_t levelCount() const {
     size_t count = 0;
-    for (SystemChar ch : m_relPath)
+    for (SystemChar ch : m_path->relPath)
       if (ch == _SYS_STR('/') || ch == _SYS_STR('\\'))
         ++count;
     return count;
@@ -1058,7 +1134,10 @@ public:
    * Fatal log report is issued if directory is not able to be created or doesn't already exist.
    * If directory already exists, no action taken.
    */
-  void makeDir() const { MakeDir(m_absPath.c_str()); }
+  void makeDir() const {
+    MakeDir(m_path->absPath.data());
+    invalidateStat();
+  }
 
   /**
    * @brief Create directory chain leading up to path
@@ -1091,13 +1170,42 @@ public:
    * @brief HECL-specific xxhash
    * @return unique hash value
    */
-  Hash hash() const noexcept { return m_hash; }
-  bool operator==(const ProjectPath& other) const noexcept { return m_hash == other.m_hash; }
+  Hash hash() const noexcept { return m_path->hash; }
+  bool operator==(const ProjectPath& other) const noexcept { return m_path->hash == other.m_path->hash; }
   bool operator!=(const ProjectPath& other) const noexcept { return !operator==(other); }
 
   uint32_t parsedHash32() const;
 };
 
+/**
+ * @brief Scope during which ProjectPath caches filesystem metadata
+ *
+ * While any session is open, getPathType(), getModtime() and the is*() tests stat each
+ * path at most once per epoch; the cache is shared by all threads. Code writing files inside
+ * a session must call ProjectPath::invalidateStat() on them, or Invalidate() when the extent
+ * of the change is unknown. Sessions may nest.
+ */
+class StatCacheSession {
+  static std::atomic_uint32_t Depth;
+  static std::atomic_uint64_t Epoch;
+
+public:
+  StatCacheSession();
+  ~StatCacheSession();
+  StatCacheSession(const StatCacheSession&) = delete;
+  StatCacheSession& operator=(const StatCacheSession&) = delete;
+
+  /**
+   * @brief Begin a new epoch, discarding everything cached so far
+   */
+  static void Invalidate() { ++Epoch; }
+
+  /**
+   * @brief Epoch cached metadata must carry to be valid, or 0 if no session is open
+   */
+  static uint64_t CurrentEpoch() { return Depth.load(std::memory_order_acquire) ? Epoch.load() : 0; }
+};
+
 /**
  * @brief Handy functions not directly provided via STL strings
  */
@@ -7,7 +7,9 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <mutex>
+#include <numeric>
 #include <string>
 #include <system_error>
 #include <thread>
@@ -27,6 +29,7 @@
 #include <io.h>
 #include <fcntl.h>
 #else
+#include <sys/mman.h>
 #include <sys/wait.h>
 #endif
 
@@ -55,6 +58,8 @@ static const uint32_t MaxBlenderMinorSearch = 92;
 
 logvisor::Module BlenderLog("hecl::blender::Connection");
 Token SharedBlenderToken;
+std::optional<HMDLTopology> MeshTopologyOverride;
+SkinBankPacking MeshSkinBankPacking = SkinBankPacking::FirstFit;
 
 #ifdef __APPLE__
 #define DEFAULT_BLENDER_BIN "/Applications/Blender.app/Contents/MacOS/blender"
@@ -121,22 +126,68 @@ static int Write(int fd, const void* buf, std::size_t size) {
   return -1;
 }
 
-static std::size_t BoundedStrLen(const char* buf, std::size_t maxLen) {
-  std::size_t ret;
-  for (ret = 0; ret < maxLen; ++ret)
-    if (buf[ret] == '\0')
-      break;
-  return ret;
+/* Used by the forked child to report launch failures in the framed format blender itself uses */
+[[maybe_unused]] static void WriteLaunchStatus(int fd, std::string_view msg) {
+  const uint32_t strLen = uint32_t(msg.size());
+  const uint32_t frameLen = strLen + 4;
+  Write(fd, &frameLen, 4);
+  Write(fd, &strLen, 4);
+  Write(fd, msg.data(), strLen);
+}
+
+bool Connection::_recvRaw(void* buf, std::size_t len) {
+  auto* cBuf = static_cast<uint8_t*>(buf);
+  while (len != 0) {
+    if (m_recvHead == m_recvTail) {
+      m_recvHead = m_recvTail = 0;
+      if (len >= RecvBufferSize) {
+        /* Large payloads skip the intermediate copy */
+        const int ret = Read(m_readpipe[0], cBuf, std::min(len, std::size_t(1) << 30));
+        if (ret <= 0)
+          return false;
+        cBuf += ret;
+        len -= ret;
+        continue;
+      }
+      const int ret = Read(m_readpipe[0], m_recvBuffer.get(), RecvBufferSize);
+      if (ret <= 0)
+        return false;
+      m_recvTail = ret;
+    }
+
+    const std::size_t copyLen = std::min(len, m_recvTail - m_recvHead);
+    std::memcpy(cBuf, m_recvBuffer.get() + m_recvHead, copyLen);
+    m_recvHead += copyLen;
+    cBuf += copyLen;
+    len -= copyLen;
+  }
+  return true;
+}
+
+bool Connection::_beginFrame() {
+  uint32_t frameLen;
+  if (!_recvRaw(&frameLen, 4))
+    return false;
+
+  if (frameLen == StatusFrame) {
+    uint32_t msgLen;
+    if (!_recvRaw(&msgLen, 4))
+      return false;
+    std::string msg(msgLen, '\0');
+    if (!_recvRaw(msg.data(), msgLen))
+      return false;
+    _blenderDied(msg);
+    return false;
+  }
+
+  m_frameRemaining = frameLen;
+  return true;
 }
 
 uint32_t Connection::_readStr(char* buf, uint32_t bufSz) {
   uint32_t readLen;
-  int ret = Read(m_readpipe[0], &readLen, sizeof(readLen));
-  if (ret < 4) {
-    BlenderLog.report(logvisor::Error, FMT_STRING("Pipe error {} {}"), ret, strerror(errno));
-    _blenderDied();
+  if (_readBuf(&readLen, 4) < 4)
     return 0;
-  }
 
   if (readLen >= bufSz) {
     BlenderLog.report(logvisor::Fatal, FMT_STRING("Pipe buffer overrun [{}/{}]"), readLen, bufSz);
@@ -144,20 +195,8 @@ uint32_t Connection::_readStr(char* buf, uint32_t bufSz) {
     return 0;
   }
 
-  ret = Read(m_readpipe[0], buf, readLen);
-  if (ret < 0) {
-    BlenderLog.report(logvisor::Fatal, FMT_STRING("{}"), strerror(errno));
+  if (_readBuf(buf, readLen) < readLen)
     return 0;
-  }
-
-  constexpr std::string_view exception_str{"EXCEPTION"};
-  const std::size_t readStrLen = BoundedStrLen(buf, readLen);
-  if (readStrLen >= exception_str.size()) {
-    if (exception_str.compare(0, exception_str.size(), std::string_view(buf, readStrLen)) == 0) {
-      _blenderDied();
-      return 0;
-    }
-  }
 
   *(buf + readLen) = '\0';
   return readLen;
@@ -183,32 +222,29 @@ uint32_t Connection::_writeStr(const char* buf, uint32_t len, int wpipe) {
 }
 
 std::size_t Connection::_readBuf(void* buf, std::size_t len) {
-  const auto error = [this] {
-    _blenderDied();
-    return 0U;
-  };
-
   auto* cBuf = static_cast<uint8_t*>(buf);
   std::size_t readLen = 0;
 
-  do {
-    const int ret = Read(m_readpipe[0], cBuf, len);
-    if (ret < 0) {
-      return error();
-    }
-
-    constexpr std::string_view exception_str{"EXCEPTION"};
-    const std::size_t readStrLen = BoundedStrLen(static_cast<char*>(buf), len);
-    if (readStrLen >= exception_str.size()) {
-      if (exception_str.compare(0, exception_str.size(), std::string_view(static_cast<char*>(buf), readStrLen)) == 0) {
+  while (len != 0) {
+    if (m_frameRemaining == 0) {
+      if (!_beginFrame()) {
         _blenderDied();
+        return readLen;
       }
+      continue;
     }
 
-    readLen += ret;
-    cBuf += ret;
-    len -= ret;
-  } while (len != 0);
+    const std::size_t chunkLen = std::min(len, std::size_t(m_frameRemaining));
+    if (!_recvRaw(cBuf, chunkLen)) {
+      _blenderDied();
+      return readLen;
+    }
+
+    m_frameRemaining -= uint32_t(chunkLen);
+    readLen += chunkLen;
+    cBuf += chunkLen;
+    len -= chunkLen;
+  }
 
   return readLen;
 }
@@ -236,6 +272,80 @@ std::size_t Connection::_writeBuf(const void* buf, std::size_t len) {
   return writeLen;
 }
 
+void Connection::_createBulkRegion() {
+#ifndef _WIN32
+#if __linux__
+  m_bulkFd = memfd_create("hecl-bulk", 0);
+#else
+  static std::atomic_uint BulkRegionIdx(0);
+  const std::string shmName = fmt::format(FMT_STRING("/hecl-bulk-{}-{}"), getpid(), BulkRegionIdx++);
+  m_bulkFd = shm_open(shmName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (m_bulkFd >= 0)
+    shm_unlink(shmName.c_str());
+#endif
+  if (m_bulkFd < 0)
+    BlenderLog.report(logvisor::Warning, FMT_STRING("unable to create bulk transfer region: {}"), strerror(errno));
+#endif
+}
+
+void Connection::_destroyBulkRegion() {
+#ifndef _WIN32
+  if (m_bulkMap)
+    munmap(m_bulkMap, m_bulkMapSz);
+  m_bulkMap = nullptr;
+  m_bulkMapSz = 0;
+  if (m_bulkFd >= 0)
+    close(m_bulkFd);
+  m_bulkFd = -1;
+#endif
+}
+
+const uint8_t* Connection::_beginBulk(std::size_t len) {
+  uint8_t tag;
+  uint32_t bulkLen;
+  _readValue(tag);
+  _readValue(bulkLen);
+  if (bulkLen != len)
+    BlenderLog.report(logvisor::Fatal, FMT_STRING("bulk transfer size mismatch [{}/{}]"), bulkLen, len);
+
+#ifndef _WIN32
+  if (tag == 1 && m_bulkFd >= 0) {
+    /* Blender only ever grows the region; remap when it has outgrown our view */
+    if (len > m_bulkMapSz) {
+      Sstat theStat;
+      if (fstat(m_bulkFd, &theStat) || std::size_t(theStat.st_size) < len)
+        BlenderLog.report(logvisor::Fatal, FMT_STRING("bulk transfer region is too small"));
+      if (m_bulkMap)
+        munmap(m_bulkMap, m_bulkMapSz);
+      m_bulkMapSz = std::size_t(theStat.st_size);
+      m_bulkMap = mmap(nullptr, m_bulkMapSz, PROT_READ, MAP_SHARED, m_bulkFd, 0);
+      if (m_bulkMap == MAP_FAILED) {
+        m_bulkMap = nullptr;
+        m_bulkMapSz = 0;
+        BlenderLog.report(logvisor::Fatal, FMT_STRING("unable to map bulk transfer region: {}"), strerror(errno));
+      }
+    }
+    m_bulkAckPending = true;
+    return static_cast<const uint8_t*>(m_bulkMap);
+  }
+#endif
+
+  if (tag != 0)
+    BlenderLog.report(logvisor::Fatal, FMT_STRING("unexpected bulk transfer tag {}"), tag);
+  m_bulkInline.resize(len);
+  _readBuf(m_bulkInline.data(), len);
+  return m_bulkInline.data();
+}
+
+void Connection::_endBulk() {
+  /* Release the region back to blender */
+  if (m_bulkAckPending) {
+    const uint8_t ack = 1;
+    _writeBuf(&ack, 1);
+    m_bulkAckPending = false;
+  }
+}
+
 ProjectPath Connection::_readPath() {
   std::string path = _readStdString();
   if (!path.empty()) {
@@ -259,7 +369,10 @@ void Connection::_closePipe() {
 #endif
 }
 
-void Connection::_blenderDied() {
+void Connection::_blenderDied(std::string_view exception) {
+  if (!exception.empty())
+    BlenderLog.report(logvisor::Fatal, FMT_STRING("Blender Exception:\n{}"), exception);
+
   std::this_thread::sleep_for(std::chrono::milliseconds(100));
   auto errFp = hecl::FopenUnique(m_errPath.c_str(), _SYS_STR("r"));
 
@@ -312,8 +425,13 @@ Connection::Connection(int verbosityLevel) {
     InstallAddon(blenderAddonPath.c_str());
   }
 
+  m_recvBuffer = std::make_unique<uint8_t[]>(RecvBufferSize);
+  _createBulkRegion();
+
   int installAttempt = 0;
   while (true) {
+    _resetRecv();
+
     /* Construct communication pipes */
 #if _WIN32
     _pipe(m_readpipe.data(), 2048, _O_BINARY);
@@ -343,6 +461,10 @@ Connection::Connection(int verbosityLevel) {
 #else
     pipe(m_readpipe.data());
     pipe(m_writepipe.data());
+#ifdef F_SETPIPE_SZ
+    /* Let blender get further ahead before blocking on a full pipe */
+    fcntl(m_readpipe[0], F_SETPIPE_SZ, int(RecvBufferSize));
+#endif
 #endif
 
       /* User-specified blender path */
@@ -454,9 +576,9 @@ Connection::Connection(int verbosityLevel) {
     pid_t pid = fork();
     if (!pid) {
       /* Close all file descriptors besides those this blender instance uses */
-      int upper_fd = std::max(m_writepipe[0], m_readpipe[1]);
+      int upper_fd = std::max({m_writepipe[0], m_readpipe[1], m_bulkFd});
       for (int i = 3; i < upper_fd; ++i) {
-        if (i != m_writepipe[0] && i != m_readpipe[1])
+        if (i != m_writepipe[0] && i != m_readpipe[1] && i != m_bulkFd)
           close(i);
       }
       closefrom(upper_fd + 1);
@@ -472,14 +594,15 @@ Connection::Connection(int verbosityLevel) {
       std::string readfds = fmt::format(FMT_STRING("{}"), m_writepipe[0]);
       std::string writefds = fmt::format(FMT_STRING("{}"), m_readpipe[1]);
       std::string vLevel = fmt::format(FMT_STRING("{}"), verbosityLevel);
+      std::string bulkfds = fmt::format(FMT_STRING("{}"), m_bulkFd);
 
       /* Try user-specified blender first */
       if (blenderBin) {
         execlp(blenderBin, blenderBin, "--background", "-P", blenderShellPath.c_str(), "--", readfds.c_str(),
-               writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), nullptr);
+               writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), bulkfds.c_str(), nullptr);
         if (errno != ENOENT) {
           errbuf = fmt::format(FMT_STRING("NOLAUNCH {}"), strerror(errno));
-          _writeStr(errbuf.c_str(), errbuf.size(), m_readpipe[1]);
+          WriteLaunchStatus(m_readpipe[1], errbuf);
           exit(1);
         }
       }
@@ -494,25 +617,25 @@ Connection::Connection(int verbosityLevel) {
 #endif
         blenderBin = steamBlender.c_str();
         execlp(blenderBin, blenderBin, "--background", "-P", blenderShellPath.c_str(), "--", readfds.c_str(),
-               writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), nullptr);
+               writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), bulkfds.c_str(), nullptr);
         if (errno != ENOENT) {
           errbuf = fmt::format(FMT_STRING("NOLAUNCH {}"), strerror(errno));
-          _writeStr(errbuf.c_str(), errbuf.size(), m_readpipe[1]);
+          WriteLaunchStatus(m_readpipe[1], errbuf);
           exit(1);
         }
       }
 
       /* Otherwise default blender */
       execlp(DEFAULT_BLENDER_BIN, DEFAULT_BLENDER_BIN, "--background", "-P", blenderShellPath.c_str(), "--",
-             readfds.c_str(), writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), nullptr);
+             readfds.c_str(), writefds.c_str(), vLevel.c_str(), blenderAddonPath.c_str(), bulkfds.c_str(), nullptr);
       if (errno != ENOENT) {
         errbuf = fmt::format(FMT_STRING("NOLAUNCH {}"), strerror(errno));
-        _writeStr(errbuf.c_str(), errbuf.size(), m_readpipe[1]);
+        WriteLaunchStatus(m_readpipe[1], errbuf);
         exit(1);
       }
 
       /* Unable to find blender */
-      _writeStr("NOBLENDER", 9, m_readpipe[1]);
+      WriteLaunchStatus(m_readpipe[1], "NOBLENDER"sv);
       exit(1);
     }
     close(m_writepipe[0]);
@@ -583,7 +706,102 @@ Connection::Connection(int verbosityLevel) {
 #endif
 }
 
-Connection::~Connection() { _closePipe(); }
+Connection::Connection(std::unique_ptr<PoolClient> pool, const PoolLease& lease) : m_pool(std::move(pool)) {
+#ifndef _WIN32
+  signal(SIGPIPE, SIG_IGN);
+#endif
+  if (hecl::VerbosityLevel >= 1)
+    BlenderLog.report(logvisor::Info, FMT_STRING("Leased pooled blender shell {}"), lease.shell);
+  m_recvBuffer = std::make_unique<uint8_t[]>(RecvBufferSize);
+  _adoptLease(lease);
+}
+
+Connection::Connection(FromRecording recording) {
+  m_recvBuffer = std::make_unique<uint8_t[]>(RecvBufferSize);
+  m_readpipe[0] = recording.readFd;
+  m_writepipe[1] = -1;
+}
+
+Connection::~Connection() {
+  _closePipe();
+  _destroyBulkRegion();
+}
+
+void Connection::_adoptLease(const PoolLease& lease) {
+#ifndef _WIN32
+  m_poolShell = lease.shell;
+  m_blenderProc = lease.pid;
+  m_readpipe[0] = lease.readFd;
+  m_writepipe[1] = lease.writeFd;
+  m_bulkFd = lease.bulkFd;
+  m_errPath = hecl::SystemString(GetTmpDir()) +
+              fmt::format(FMT_STRING(_SYS_STR("/hecl_{:016X}.derp")), (unsigned long long)m_blenderProc);
+#endif
+  _resetRecv();
+  m_loadedBlend = ProjectPath();
+  m_loadedType = BlendType::None;
+  m_loadedRigged = false;
+  m_loadedModtime = 0;
+  m_loadedSize = 0;
+}
+
+void Connection::_returnLease() {
+  _closePipe();
+  m_readpipe[0] = -1;
+  m_writepipe[1] = -1;
+  _destroyBulkRegion();
+  m_poolShell = UINT32_MAX;
+}
+
+PoolShellState Connection::_poolState() const {
+  PoolShellState state;
+  if (m_loadedBlend) {
+    state.blendHash = m_loadedBlend.hash().val64();
+    state.blendModtime = m_loadedModtime;
+    state.blendSize = m_loadedSize;
+    state.blendType = uint32_t(m_loadedType);
+    state.blendRigged = m_loadedRigged;
+  }
+  return state;
+}
+
+bool Connection::_poolSwitch(const ProjectPath& path) {
+  /* Trade the current shell for one that may already have path loaded */
+  const uint64_t blendHash = path.hash().val64();
+  const PoolShellState returnState = _poolState();
+  const uint32_t returnShell = m_poolShell;
+  _returnLease();
+  const PoolLease lease = m_pool->acquire(blendHash, returnShell, returnState);
+  if (!lease)
+    BlenderLog.report(logvisor::Fatal, FMT_STRING("lost connection to blender pool daemon"));
+  _adoptLease(lease);
+
+  if (lease.state.blendHash != blendHash || !lease.state.blendModtime)
+    return false;
+  Sstat theStat;
+  if (hecl::Stat(path.getAbsolutePath().data(), &theStat) || theStat.st_mtime != lease.state.blendModtime ||
+      uint64_t(theStat.st_size) != lease.state.blendSize)
+    return false;
+
+  m_loadedBlend = path;
+  m_loadedType = BlendType(lease.state.blendType);
+  m_loadedRigged = lease.state.blendRigged != 0;
+  m_loadedModtime = lease.state.blendModtime;
+  m_loadedSize = lease.state.blendSize;
+  return true;
+}
+
+void Connection::_stampLoadedBlend() {
+  /* Files modified within the current second may change again without affecting the stamp */
+  Sstat theStat;
+  if (!hecl::Stat(m_loadedBlend.getAbsolutePath().data(), &theStat) && theStat.st_mtime < std::time(nullptr)) {
+    m_loadedModtime = theStat.st_mtime;
+    m_loadedSize = uint64_t(theStat.st_size);
+  } else {
+    m_loadedModtime = 0;
+    m_loadedSize = 0;
+  }
+}
 
 void Vector2f::read(Connection& conn) { conn._readBuf(&val, 8); }
 void Vector3f::read(Connection& conn) { conn._readBuf(&val, 12); }
@@ -660,6 +878,8 @@ bool Connection::createBlend(const ProjectPath& path, BlendType type) {
     hecl::Unlink(path.getAbsolutePath().data());
     m_loadedBlend = path;
     m_loadedType = type;
+    m_loadedModtime = 0;
+    m_loadedSize = 0;
     return true;
   }
   return false;
@@ -673,9 +893,12 @@ bool Connection::openBlend(const ProjectPath& path, bool force) {
   }
   if (!force && path == m_loadedBlend)
     return true;
+  if (m_pool && !force && _poolSwitch(path))
+    return true;
   _writeStr(fmt::format(FMT_STRING("OPEN \"{}\""), path.getAbsolutePathUTF8()));
   if (_isFinished()) {
     m_loadedBlend = path;
+    _stampLoadedBlend();
     _writeStr("GETTYPE");
     std::string typeStr = _readStdString();
     m_loadedType = BlendType::None;
@@ -705,7 +928,10 @@ bool Connection::saveBlend() {
     return false;
   }
   _writeStr("SAVE");
-  return _isFinished();
+  if (!_isFinished())
+    return false;
+  _stampLoadedBlend();
+  return true;
 }
 
 void Connection::deleteBlend() {
@@ -926,7 +1152,7 @@ void Mesh::normalizeSkinBinds() {
 }
 
 Mesh::Mesh(Connection& conn, HMDLTopology topologyIn, int skinSlotCount, bool useLuvs)
-: topology(topologyIn), sceneXf(conn), aabbMin(conn), aabbMax(conn) {
+: topology(MeshTopologyOverride.value_or(topologyIn)), sceneXf(conn), aabbMin(conn), aabbMax(conn) {
   conn._readVectorFunc(materialSets, [&]() { conn._readVector(materialSets.emplace_back()); });
 
   MeshOptimizer opt(conn, materialSets[0], useLuvs);
@@ -934,8 +1160,7 @@ Mesh::Mesh(Connection& conn, HMDLTopology topologyIn, int skinSlotCount, bool us
 
   conn._readVector(boneNames);
   if (boneNames.size())
-    for (Surface& s : surfaces)
-      s.skinBankIdx = skinBanks.addSurface(*this, s, skinSlotCount);
+    skinBanks.addSurfaces(*this, skinSlotCount, MeshSkinBankPacking);
 
   /* Custom properties */
   uint32_t propCount;
@@ -947,57 +1172,80 @@ Mesh::Mesh(Connection& conn, HMDLTopology topologyIn, int skinSlotCount, bool us
     valBuf = conn._readStdString();
     customProps[keyBuf] = valBuf;
   }
+}
+
+Mesh::ContiguousSkinningView Mesh::getContiguousSkinningView() const {
+  ContiguousSkinningView ret{*this};
+
+  /* Number surface verts in mesh order */
+  ret.surfaceOffsets.reserve(surfaces.size());
+  std::size_t vertTotal = 0;
+  for (const Surface& surf : surfaces) {
+    ret.surfaceOffsets.push_back(vertTotal);
+    vertTotal += surf.verts.size();
+  }
+  ret.vertIdxs.assign(vertTotal, UINT32_MAX);
 
-  /* Connect skinned verts to bank slots */
-  if (boneNames.size()) {
-    for (Surface& surf : surfaces) {
-      SkinBanks::Bank& bank = skinBanks.banks[surf.skinBankIdx];
-      for (Surface::Vert& vert : surf.verts) {
-        if (vert.iPos == 0xffffffff)
-          continue;
-        for (uint32_t i = 0; i < bank.m_skinIdxs.size(); ++i) {
-          if (bank.m_skinIdxs[i] == vert.iSkin) {
-            vert.iBankSkin = i;
-            break;
-          }
-        }
+  /* Bucket skinned verts by skin with a counting sort, keeping mesh order within each skin */
+  struct BucketedVert {
+    const Surface::Vert* vert;
+    std::size_t idx;
+  };
+  std::vector<std::size_t> bucketStart(skins.size() + 1);
+  for (const Surface& surf : surfaces)
+    for (const Surface::Vert& vert : surf.verts)
+      if (vert.iPos != 0xffffffff && vert.iSkin < skins.size())
+        ++bucketStart[vert.iSkin + 1];
+  for (std::size_t i = 1; i < bucketStart.size(); ++i)
+    bucketStart[i] += bucketStart[i - 1];
+  std::vector<BucketedVert> bucketed(bucketStart.back());
+  std::vector<std::size_t> bucketCursor(bucketStart.begin(), bucketStart.end() - 1);
+  std::size_t idx = 0;
+  for (const Surface& surf : surfaces)
+    for (const Surface::Vert& vert : surf.verts) {
+      if (vert.iPos != 0xffffffff && vert.iSkin < skins.size())
+        bucketed[bucketCursor[vert.iSkin]++] = {&vert, idx};
+      ++idx;
+    }
+
+  /* Emit one pos/norm pair per distinct (pos, norm) of each skin */
+  ret.pos.reserve(bucketed.size());
+  ret.norm.reserve(bucketed.size());
+  ret.skinVertCounts.reserve(skins.size());
+  std::unordered_map<uint64_t, uint32_t> contigMap;
+  for (std::size_t i = 0; i < skins.size(); ++i) {
+    contigMap.clear();
+    const std::size_t skinStart = ret.pos.size();
+    for (std::size_t j = bucketStart[i]; j < bucketStart[i + 1]; ++j) {
+      const Surface::Vert& vert = *bucketed[j].vert;
+      const auto [it, inserted] =
+          contigMap.emplace((uint64_t(vert.iPos) << 32) | vert.iNorm, uint32_t(ret.pos.size()));
+      if (inserted) {
+        ret.pos.push_back(pos[vert.iPos]);
+        ret.norm.push_back(norm[vert.iNorm]);
       }
+      ret.vertIdxs[bucketed[j].idx] = it->second;
     }
+    ret.skinVertCounts.push_back(ret.pos.size() - skinStart);
   }
+  return ret;
 }
 
 Mesh Mesh::getContiguousSkinningVersion() const {
+  ContiguousSkinningView view = getContiguousSkinningView();
   Mesh newMesh = *this;
-  newMesh.pos.clear();
-  newMesh.norm.clear();
-  newMesh.contiguousSkinVertCounts.clear();
-  newMesh.contiguousSkinVertCounts.reserve(skins.size());
-  for (std::size_t i = 0; i < skins.size(); ++i) {
-    std::unordered_map<std::pair<uint32_t, uint32_t>, uint32_t> contigMap;
-    std::size_t vertCount = 0;
-    for (Surface& surf : newMesh.surfaces) {
-      for (Surface::Vert& vert : surf.verts) {
-        if (vert.iPos == 0xffffffff)
-          continue;
-        if (vert.iSkin == i) {
-          auto key = std::make_pair(vert.iPos, vert.iNorm);
-          auto search = contigMap.find(key);
-          if (search != contigMap.end()) {
-            vert.iPos = search->second;
-            vert.iNorm = search->second;
-          } else {
-            uint32_t newIdx = newMesh.pos.size();
-            contigMap[key] = newIdx;
-            newMesh.pos.push_back(pos.at(vert.iPos));
-            newMesh.norm.push_back(norm.at(vert.iNorm));
-            vert.iPos = newIdx;
-            vert.iNorm = newIdx;
-            ++vertCount;
-          }
-        }
+  newMesh.pos = std::move(view.pos);
+  newMesh.norm = std::move(view.norm);
+  newMesh.contiguousSkinVertCounts = std::move(view.skinVertCounts);
+  for (std::size_t s = 0; s < newMesh.surfaces.size(); ++s) {
+    std::vector<Surface::Vert>& verts = newMesh.surfaces[s].verts;
+    for (std::size_t v = 0; v < verts.size(); ++v) {
+      const uint32_t newIdx = view.getVertIdx(s, v);
+      if (newIdx != UINT32_MAX) {
+        verts[v].iPos = newIdx;
+        verts[v].iNorm = newIdx;
       }
     }
-    newMesh.contiguousSkinVertCounts.push_back(vertCount);
   }
   return newMesh;
 }
@@ -1057,80 +1305,133 @@ bool Mesh::Surface::Vert::operator==(const Vert& other) const {
          std::tie(other.iPos, other.iNorm, other.iColor, other.iUv, other.iSkin);
 }
 
-static bool VertInBank(const std::vector<uint32_t>& bank, uint32_t sIdx) {
-  return std::any_of(bank.cbegin(), bank.cend(), [sIdx](auto index) { return index == sIdx; });
-}
-
 void Mesh::SkinBanks::Bank::addSkins(const Mesh& parent, const std::vector<uint32_t>& skinIdxs) {
   for (uint32_t sidx : skinIdxs) {
     m_skinIdxs.push_back(sidx);
+    m_skinMask.set(sidx);
     for (const SkinBind& bind : parent.skins[sidx]) {
       if (!bind.valid())
         break;
-      bool found = false;
-      for (uint32_t bidx : m_boneIdxs) {
-        if (bidx == bind.vg_idx) {
-          found = true;
-          break;
-        }
-      }
-      if (!found)
+      if (bind.vg_idx >= m_boneMask.size())
+        m_boneMask.resize(bind.vg_idx + 1);
+      if (!m_boneMask[bind.vg_idx]) {
+        m_boneMask.set(bind.vg_idx);
         m_boneIdxs.push_back(bind.vg_idx);
+      }
     }
   }
 }
 
-std::vector<Mesh::SkinBanks::Bank>::iterator Mesh::SkinBanks::addSkinBank(int skinSlotCount) {
-  banks.emplace_back();
+std::vector<Mesh::SkinBanks::Bank>::iterator Mesh::SkinBanks::addSkinBank(const Mesh& mesh, int skinSlotCount) {
+  Bank& bank = banks.emplace_back();
   if (skinSlotCount > 0)
-    banks.back().m_skinIdxs.reserve(skinSlotCount);
+    bank.m_skinIdxs.reserve(skinSlotCount);
+  bank.m_skinMask.resize(unsigned(mesh.skins.size()));
+  bank.m_boneMask.resize(unsigned(mesh.boneNames.size()));
   return banks.end() - 1;
 }
 
-uint32_t Mesh::SkinBanks::addSurface(const Mesh& mesh, const Surface& surf, int skinSlotCount) {
-  if (banks.empty())
-    addSkinBank(skinSlotCount);
-  std::vector<uint32_t> toAdd;
-  if (skinSlotCount > 0)
-    toAdd.reserve(skinSlotCount);
-  std::vector<Bank>::iterator bankIt = banks.begin();
-  for (;;) {
-    bool done = true;
-    for (; bankIt != banks.end(); ++bankIt) {
-      Bank& bank = *bankIt;
-      done = true;
-      for (const Surface::Vert& v : surf.verts) {
-        if (v.iPos == 0xffffffff)
-          continue;
-        if (!VertInBank(bank.m_skinIdxs, v.iSkin) && !VertInBank(toAdd, v.iSkin)) {
-          toAdd.push_back(v.iSkin);
-          if (skinSlotCount > 0 && bank.m_skinIdxs.size() + toAdd.size() > std::size_t(skinSlotCount)) {
-            toAdd.clear();
-            done = false;
-            break;
-          }
-        }
-      }
-      if (toAdd.size()) {
-        bank.addSkins(mesh, toAdd);
-        toAdd.clear();
-      }
-      if (done)
-        return uint32_t(bankIt - banks.begin());
-    }
-    if (!done) {
-      bankIt = addSkinBank(skinSlotCount);
+void Mesh::SkinBanks::_gatherSkins(const Mesh& mesh, const Surface& surf, std::vector<uint32_t>& skinsOut) {
+  if (m_gathered.size() < mesh.skins.size())
+    m_gathered.resize(unsigned(mesh.skins.size()));
+  skinsOut.clear();
+  for (const Surface::Vert& v : surf.verts) {
+    if (v.iPos == 0xffffffff || m_gathered[v.iSkin])
       continue;
-    }
-    break;
+    m_gathered.set(v.iSkin);
+    skinsOut.push_back(v.iSkin);
   }
-  return uint32_t(-1);
+  for (uint32_t sidx : skinsOut)
+    m_gathered.reset(sidx);
+}
+
+uint32_t Mesh::SkinBanks::_placeSurface(const Mesh& mesh, Surface& surf, const std::vector<uint32_t>& surfSkins,
+                                        int skinSlotCount) {
+  if (skinSlotCount > 0 && surfSkins.size() > std::size_t(skinSlotCount))
+    BlenderLog.report(logvisor::Fatal, FMT_STRING("surface uses {} skins, more than the {} slots of a skin bank"),
+                      surfSkins.size(), skinSlotCount);
+
+  /* First bank with room for the skins it lacks */
+  std::vector<uint32_t> toAdd;
+  toAdd.reserve(surfSkins.size());
+  uint32_t bankIdx = 0;
+  for (; bankIdx < banks.size(); ++bankIdx) {
+    const Bank& bank = banks[bankIdx];
+    toAdd.clear();
+    for (uint32_t sidx : surfSkins)
+      if (!bank.hasSkin(sidx))
+        toAdd.push_back(sidx);
+    if (skinSlotCount <= 0 || bank.m_skinIdxs.size() + toAdd.size() <= std::size_t(skinSlotCount))
+      break;
+  }
+  if (bankIdx == banks.size()) {
+    addSkinBank(mesh, skinSlotCount);
+    toAdd = surfSkins;
+  }
+  Bank& bank = banks[bankIdx];
+  bank.addSkins(mesh, toAdd);
+
+  /* Banks only ever grow, so the slot table needs refilling only when the bank changes */
+  if (m_skinSlots.size() < mesh.skins.size())
+    m_skinSlots.resize(mesh.skins.size());
+  if (m_slotsBank != bankIdx) {
+    m_slotsBank = bankIdx;
+    m_slotsFilled = 0;
+  }
+  for (; m_slotsFilled < bank.m_skinIdxs.size(); ++m_slotsFilled)
+    m_skinSlots[bank.m_skinIdxs[m_slotsFilled]] = uint32_t(m_slotsFilled);
+  for (Surface::Vert& v : surf.verts)
+    if (v.iPos != 0xffffffff)
+      v.iBankSkin = m_skinSlots[v.iSkin];
+
+  surf.skinBankIdx = bankIdx;
+  return bankIdx;
+}
+
+uint32_t Mesh::SkinBanks::addSurface(const Mesh& mesh, Surface& surf, int skinSlotCount) {
+  std::vector<uint32_t> surfSkins;
+  _gatherSkins(mesh, surf, surfSkins);
+  return _placeSurface(mesh, surf, surfSkins, skinSlotCount);
+}
+
+void Mesh::SkinBanks::addSurfaces(Mesh& mesh, int skinSlotCount, SkinBankPacking packing) {
+  std::vector<std::vector<uint32_t>> surfSkins(mesh.surfaces.size());
+  for (std::size_t i = 0; i < mesh.surfaces.size(); ++i)
+    _gatherSkins(mesh, mesh.surfaces[i], surfSkins[i]);
+
+  std::vector<uint32_t> order(mesh.surfaces.size());
+  std::iota(order.begin(), order.end(), 0);
+  if (packing == SkinBankPacking::FirstFitDecreasing)
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return surfSkins[a].size() > surfSkins[b].size(); });
+
+  for (uint32_t i : order)
+    _placeSurface(mesh, mesh.surfaces[i], surfSkins[i], skinSlotCount);
 }
 
 ColMesh::ColMesh(Connection& conn) {
   conn._readVector(materials);
-  conn._readVector(verts);
-  conn._readVector(edges);
+
+  uint32_t vertCount;
+  conn._readValue(vertCount);
+  verts.resize(vertCount);
+  const uint8_t* vertData = conn._beginBulk(vertCount * 12);
+  for (uint32_t i = 0; i < vertCount; ++i)
+    std::memcpy(&verts[i].val, vertData + i * 12, 12);
+  conn._endBulk();
+
+  uint32_t edgeCount;
+  conn._readValue(edgeCount);
+  edges.resize(edgeCount);
+  const uint8_t* edgeVertData = conn._beginBulk(edgeCount * 8);
+  for (uint32_t i = 0; i < edgeCount; ++i)
+    std::memcpy(edges[i].verts.data(), edgeVertData + i * 8, 8);
+  conn._endBulk();
+  const uint8_t* edgeSeamData = conn._beginBulk(edgeCount);
+  for (uint32_t i = 0; i < edgeCount; ++i)
+    edges[i].seam = edgeSeamData[i] != 0;
+  conn._endBulk();
+
   conn._readVector(trianges);
 }
 
@@ -1139,8 +1440,6 @@ ColMesh::Material::Material(Connection& conn) {
   conn._readBuf(&unknown, 42);
 }
 
-ColMesh::Edge::Edge(Connection& conn) { conn._readBuf(this, 9); }
-
 ColMesh::Triangle::Triangle(Connection& conn) { conn._readBuf(this, 17); }
 
 World::Area::Dock::Dock(Connection& conn) {
@@ -1706,6 +2005,13 @@ void Connection::quitBlender() {
     }
     m_lock = false;
   }
+  if (m_pool) {
+    /* Pooled shells stay up for the next lease */
+    m_pool->release(m_poolShell, _poolState());
+    _returnLease();
+    m_pool.reset();
+    return;
+  }
   _writeStr("QUIT");
   _readStr(lineBuf, sizeof(lineBuf));
 #ifndef _WIN32
@@ -1718,8 +2024,16 @@ Connection& Connection::SharedConnection() { return SharedBlenderToken.getBlende
 void Connection::Shutdown() { SharedBlenderToken.shutdown(); }
 
 Connection& Token::getBlenderConnection() {
-  if (!m_conn)
-    m_conn = std::make_unique<Connection>(hecl::VerbosityLevel);
+  if (!m_conn) {
+    /* Prefer a warm shell from `hecl blenderpool` when one is running */
+    if (auto pool = PoolClient::Connect()) {
+      const PoolLease lease = pool->acquire(0);
+      if (lease)
+        m_conn = std::make_unique<Connection>(std::move(pool), lease);
+    }
+    if (!m_conn)
+      m_conn = std::make_unique<Connection>(hecl::VerbosityLevel);
+  }
   return *m_conn;
 }
 
@@ -1739,13 +2053,19 @@ HMDLBuffers::HMDLBuffers(HMDLMeta&& meta, std::size_t vboSz, const std::vector<a
 : m_meta(std::move(meta))
 , m_vboSz(vboSz)
 , m_vboData(new uint8_t[vboSz])
-, m_iboSz(iboData.size() * 4)
-, m_iboData(new uint8_t[iboData.size() * 4])
+, m_iboSz(iboData.size() * (True(m_meta.flags & HMDLFlags::ShortIndices) ? 2 : 4))
+, m_iboData(new uint8_t[m_iboSz])
 , m_surfaces(std::move(surfaces))
 , m_skinBanks(skinBanks) {
   if (m_iboSz) {
     athena::io::MemoryWriter w(m_iboData.get(), m_iboSz);
-    w.enumerateLittle(iboData);
+    if (True(m_meta.flags & HMDLFlags::ShortIndices)) {
+      /* Restart index 0xffffffff narrows to 0xffff */
+      for (atUint32 idx : iboData)
+        w.writeUint16Little(atUint16(idx));
+    } else {
+      w.enumerateLittle(iboData);
+    }
   }
 }
 
@@ -1,8 +1,10 @@
 #include "hecl/Blender/Connection.hpp"
 
+#include <algorithm>
 #include <cfloat>
 #include <cmath>
 #include <cstddef>
+#include <unordered_map>
 #include <vector>
 
 #include <athena/MemoryWriter.hpp>
@@ -11,6 +13,24 @@
 #undef max
 
 namespace hecl::blender {
+namespace {
+/* Identifies a VBO vertex; equal attribute indices in different skin banks bind different bones */
+struct PoolVertKey {
+  const Mesh::Surface::Vert* vert;
+  uint32_t skinBankIdx;
+  bool operator==(const PoolVertKey& other) const {
+    return skinBankIdx == other.skinBankIdx && *vert == *other.vert;
+  }
+};
+
+struct PoolVertKeyHash {
+  std::size_t operator()(const PoolVertKey& key) const noexcept {
+    std::size_t h = std::hash<Mesh::Surface::Vert>()(*key.vert);
+    hecl::hash_combine_impl(h, std::size_t(key.skinBankIdx));
+    return h;
+  }
+};
+} // namespace
 
 atVec3f MtxVecMul4RM(const Matrix4f& mtx, const Vector3f& vec) {
   atVec3f res;
@@ -40,7 +60,7 @@ atVec3f MtxVecMul3RM(const Matrix4f& mtx, const Vector3f& vec) {
   return res;
 }
 
-HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinIndex) const {
+HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinIndex, HMDLFlags packing) const {
   /* If skinned, compute max weight vec count */
   size_t weightCount = 0;
   for (const SkinBanks::Bank& bank : skinBanks.banks)
@@ -52,7 +72,8 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
   /* Prepare HMDL meta */
   HMDLMeta metaOut;
   metaOut.topology = topology;
-  metaOut.vertStride = (3 + 3 + colorLayerCount + uvLayerCount * 2 + weightVecCount * 4) * 4;
+  metaOut.flags = packing & (HMDLFlags::VertexPackingMask | HMDLFlags::ShortIndices);
+  metaOut.vertStride = HMDLVertStride(metaOut.flags, colorLayerCount, uvLayerCount, weightVecCount);
   metaOut.colorCount = colorLayerCount;
   metaOut.uvCount = uvLayerCount;
   metaOut.weightCount = weightVecCount;
@@ -66,6 +87,8 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
   /* Maintain unique vert pool for VBO */
   std::vector<std::pair<const Surface*, const Surface::Vert*>> vertPool;
   vertPool.reserve(boundVerts);
+  std::unordered_map<PoolVertKey, uint32_t, PoolVertKeyHash> vertLookup;
+  vertLookup.reserve(boundVerts);
 
   /* Target surfaces representation */
   std::vector<HMDLBuffers::Surface> outSurfaces;
@@ -83,26 +106,52 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
         continue;
       }
 
-      size_t ti = 0;
-      bool found = false;
-      for (const std::pair<const Surface*, const Surface::Vert*>& tv : vertPool) {
-        if (v == *tv.second && surf.skinBankIdx == tv.first->skinBankIdx) {
-          iboData.push_back(ti);
-          found = true;
-          break;
-        }
-        ++ti;
-      }
-      if (!found) {
-        iboData.push_back(vertPool.size());
+      const auto [it, inserted] = vertLookup.try_emplace({&v, surf.skinBankIdx}, uint32_t(vertPool.size()));
+      iboData.push_back(it->second);
+      if (inserted)
         vertPool.emplace_back(&surf, &v);
-      }
     }
     outSurfaces.emplace_back(surf, iboStart, iboData.size() - iboStart);
   }
 
   metaOut.vertCount = vertPool.size();
   metaOut.indexCount = iboData.size();
+  /* Short indices are requested, not guaranteed; 0xffff is reserved for primitive restart */
+  if (vertPool.size() > 0xffff)
+    metaOut.flags &= ~HMDLFlags::ShortIndices;
+
+  const bool packPositions = True(metaOut.flags & HMDLFlags::PackedPositions);
+  const bool octNormals = True(metaOut.flags & HMDLFlags::OctNormals);
+  const bool halfUVs = True(metaOut.flags & HMDLFlags::HalfUVs);
+  const bool packWeights = True(metaOut.flags & HMDLFlags::PackedWeights);
+
+  auto vertPos = [&](const Surface::Vert& v) -> atVec3f {
+    return absoluteCoords ? MtxVecMul4RM(sceneXf, pos[v.iPos]) : pos[v.iPos].val;
+  };
+
+  /* Packed positions are normalized to the bounds of the positions actually written */
+  athena::simd_floats posMin;
+  athena::simd_floats posScale;
+  for (int i = 0; i < 4; ++i)
+    posMin[i] = posScale[i] = 0.f;
+  if (packPositions && !vertPool.empty()) {
+    athena::simd_floats posMax;
+    for (int i = 0; i < 3; ++i) {
+      posMin[i] = FLT_MAX;
+      posMax[i] = -FLT_MAX;
+    }
+    for (const auto& sv : vertPool) {
+      athena::simd_floats p(vertPos(*sv.second).simd);
+      for (int i = 0; i < 3; ++i) {
+        posMin[i] = std::min(posMin[i], p[i]);
+        posMax[i] = std::max(posMax[i], p[i]);
+      }
+    }
+    for (int i = 0; i < 3; ++i)
+      posScale[i] = posMax[i] - posMin[i];
+  }
+  metaOut.posMin.simd.copy_from(posMin);
+  metaOut.posScale.simd.copy_from(posScale);
 
   size_t vboSz = metaOut.vertCount * metaOut.vertStride;
   poolSkinIndex.allocate(vertPool.size());
@@ -113,20 +162,39 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
     const Surface& s = *sv.first;
     const Surface::Vert& v = *sv.second;
 
+    const atVec3f vPos = vertPos(v);
+    atVec3f vNorm;
     if (absoluteCoords) {
-      atVec3f preXfPos = MtxVecMul4RM(sceneXf, pos[v.iPos]);
-      vboW.writeVec3fLittle(preXfPos);
-
-      atVec3f preXfNorm = MtxVecMul3RM(sceneXf, norm[v.iNorm]);
-      athena::simd_floats f(preXfNorm.simd * preXfNorm.simd);
+      vNorm = MtxVecMul3RM(sceneXf, norm[v.iNorm]);
+      athena::simd_floats f(vNorm.simd * vNorm.simd);
       float mag = f[0] + f[1] + f[2];
       if (mag > FLT_EPSILON)
         mag = 1.f / std::sqrt(mag);
-      preXfNorm.simd *= mag;
-      vboW.writeVec3fLittle(preXfNorm);
+      vNorm.simd *= mag;
+    } else {
+      vNorm = norm[v.iNorm].val;
+    }
+
+    if (packPositions) {
+      athena::simd_floats p(vPos.simd);
+      for (int i = 0; i < 3; ++i) {
+        const float t = posScale[i] > 0.f ? (p[i] - posMin[i]) / posScale[i] : 0.f;
+        vboW.writeUint16Little(atUint16(std::lround(std::clamp(t, 0.f, 1.f) * 65535.f)));
+      }
+      vboW.writeUint16Little(0);
     } else {
-      vboW.writeVec3fLittle(pos[v.iPos]);
-      vboW.writeVec3fLittle(norm[v.iNorm]);
+      vboW.writeVec3fLittle(vPos);
+    }
+
+    if (octNormals) {
+      athena::simd_floats n(vNorm.simd);
+      const float nf[3] = {n[0], n[1], n[2]};
+      atInt16 oct[2];
+      OctEncodeNormal(nf, oct);
+      vboW.writeInt16Little(oct[0]);
+      vboW.writeInt16Little(oct[1]);
+    } else {
+      vboW.writeVec3fLittle(vNorm);
     }
 
     for (size_t i = 0; i < colorLayerCount; ++i) {
@@ -138,8 +206,15 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
       vboW.writeUByte(255);
     }
 
-    for (size_t i = 0; i < uvLayerCount; ++i)
-      vboW.writeVec2fLittle(uv[v.iUv[i]]);
+    for (size_t i = 0; i < uvLayerCount; ++i) {
+      if (halfUVs) {
+        athena::simd_floats f(uv[v.iUv[i]].val.simd);
+        vboW.writeUint16Little(FloatToHalf(f[0]));
+        vboW.writeUint16Little(FloatToHalf(f[1]));
+      } else {
+        vboW.writeVec2fLittle(uv[v.iUv[i]]);
+      }
+    }
 
     if (weightVecCount) {
       const SkinBanks::Bank& bank = skinBanks.banks[s.skinBankIdx];
@@ -161,7 +236,13 @@ HMDLBuffers Mesh::getHMDLBuffers(bool absoluteCoords, PoolSkinIndex& poolSkinInd
           }
           ++it;
         }
-        vboW.writeVec4fLittle(vec);
+        if (packWeights) {
+          athena::simd_floats f(vec.simd);
+          for (size_t j = 0; j < 4; ++j)
+            vboW.writeUByte(atUint8(std::lround(std::clamp(f[j], 0.f, 1.f) * 255.f)));
+        } else {
+          vboW.writeVec4fLittle(vec);
+        }
       }
     }
 
@@ -1,43 +1,25 @@
 #include "MeshOptimizer.hpp"
 
 #include <algorithm>
+#include <atomic>
 #include <cfloat>
 #include <climits>
 #include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <unordered_set>
 
+#include "hecl/ClientProcess.hpp"
+
 namespace hecl::blender {
 
 logvisor::Module Log("MeshOptimizer");
 
-template <typename T>
-static void insert_unique_attr(std::unordered_map<T, uint32_t>& set, const T& attr) {
-  if (set.find(attr) == set.cend()) {
-    size_t sz = set.size();
-    set.insert(std::make_pair(attr, sz));
-  }
-}
-
-template <typename T>
-static std::vector<T> sort_unordered_map(const std::unordered_map<T, uint32_t>& map) {
-  struct SortableIterator {
-    typename std::unordered_map<T, uint32_t>::const_iterator it;
-    bool operator<(const SortableIterator& other) const { return it->second < other.it->second; }
-    explicit SortableIterator(typename std::unordered_map<T, uint32_t>::const_iterator i) : it(i) {}
-  };
-  std::vector<SortableIterator> to_sort;
-  to_sort.reserve(map.size());
-  for (auto I = map.cbegin(), E = map.cend(); I != E; ++I)
-    to_sort.emplace_back(I);
-  std::sort(to_sort.begin(), to_sort.end());
-  std::vector<T> ret;
-  ret.reserve(to_sort.size());
-  for (const auto& sit : to_sort)
-    ret.push_back(sit.it->first);
-  return ret;
-}
-
 static bool material_is_lightmapped(const Material& mat) {
   auto search = mat.iprops.find("retro_lightmapped");
   if (search != mat.iprops.cend())
@@ -45,94 +27,32 @@ static bool material_is_lightmapped(const Material& mat) {
   return false;
 }
 
-MeshOptimizer::Vertex::Vertex(Connection& conn) {
-  co.read(conn);
-  uint32_t skin_count;
-  conn._readValue(skin_count);
-  if (skin_count > MaxSkinEntries)
-    Log.report(logvisor::Fatal, FMT_STRING("Skin entry overflow {}/{}"), skin_count, MaxSkinEntries);
-  for (uint32_t i = 0; i < skin_count; ++i)
-    skin_ents[i] = Mesh::SkinBind(conn);
-}
-
-MeshOptimizer::Loop::Loop(Connection& conn, uint32_t color_count, uint32_t uv_count) {
-  normal.read(conn);
-  for (uint32_t i = 0; i < color_count; ++i)
-    colors[i].read(conn);
-  for (uint32_t i = 0; i < uv_count; ++i)
-    uvs[i].read(conn);
-  conn._readValue(vert);
-  conn._readValue(edge);
-  conn._readValue(face);
-  conn._readValue(link_loop_next);
-  conn._readValue(link_loop_prev);
-  conn._readValue(link_loop_radial_next);
-  conn._readValue(link_loop_radial_prev);
-}
-
-MeshOptimizer::Edge::Edge(Connection& conn) {
-  for (uint32_t i = 0; i < 2; ++i)
-    conn._readValue(verts[i]);
-  uint32_t face_count;
-  conn._readValue(face_count);
-  if (face_count > MaxLinkFaces)
-    Log.report(logvisor::Fatal, FMT_STRING("Face overflow {}/{}"), face_count, MaxLinkFaces);
-  for (uint32_t i = 0; i < face_count; ++i)
-    conn._readValue(link_faces[i]);
-  conn._readValue(is_contiguous);
-}
-
-MeshOptimizer::Face::Face(Connection& conn) {
-  normal.read(conn);
-  centroid.read(conn);
-  conn._readValue(material_index);
-  for (uint32_t i = 0; i < 3; ++i)
-    conn._readValue(loops[i]);
-}
+uint32_t MeshOptimizer::get_pos_idx(uint32_t vert) const { return b_pos.find(vert_co[vert]); }
 
-uint32_t MeshOptimizer::get_pos_idx(const Vertex& v) const {
-  auto search = b_pos.find(v.co);
-  if (search != b_pos.cend())
-    return search->second;
-  return UINT32_MAX;
-}
+uint32_t MeshOptimizer::get_norm_idx(uint32_t loop) const { return b_norm.find(loop_normal[loop]); }
 
-uint32_t MeshOptimizer::get_norm_idx(const Loop& l) const {
-  auto search = b_norm.find(l.normal);
-  if (search != b_norm.cend())
-    return search->second;
-  return UINT32_MAX;
+uint32_t MeshOptimizer::get_skin_idx(uint32_t vert) const {
+  if (vert_skins.empty())
+    return UINT32_MAX;
+  return b_skin.find(vert_skins[vert]);
 }
 
-uint32_t MeshOptimizer::get_skin_idx(const Vertex& v) const {
-  auto search = b_skin.find(v.skin_ents);
-  if (search != b_skin.cend())
-    return search->second;
-  return UINT32_MAX;
+uint32_t MeshOptimizer::get_color_idx(uint32_t loop, uint32_t cidx) const {
+  return b_color.find(loop_colors[cidx][loop]);
 }
 
-uint32_t MeshOptimizer::get_color_idx(const Loop& l, uint32_t cidx) const {
-  auto search = b_color.find(l.colors[cidx]);
-  if (search != b_color.cend())
-    return search->second;
-  return UINT32_MAX;
+bool MeshOptimizer::loop_uses_luv(uint32_t loop) const {
+  return use_luvs && uv_count && material_is_lightmapped(materials[faces[loop_face[loop]].material_index]);
 }
 
-uint32_t MeshOptimizer::get_uv_idx(const Loop& l, uint32_t uidx) const {
-  if (use_luvs && uidx == 0 && material_is_lightmapped(materials[faces[l.face].material_index])) {
-    auto search = b_luv.find(l.uvs[0]);
-    if (search != b_luv.cend())
-      return search->second;
-    return UINT32_MAX;
-  }
-  auto search = b_uv.find(l.uvs[uidx]);
-  if (search != b_uv.cend())
-    return search->second;
-  return UINT32_MAX;
+uint32_t MeshOptimizer::get_uv_idx(uint32_t loop, uint32_t uidx) const {
+  if (uidx == 0 && loop_uses_luv(loop))
+    return b_luv.find(loop_uvs[0][loop]);
+  return b_uv.find(loop_uvs[uidx][loop]);
 }
 
-bool MeshOptimizer::loops_contiguous(const Loop& la, const Loop& lb) const {
-  if (la.vert != lb.vert)
+bool MeshOptimizer::loops_contiguous(uint32_t la, uint32_t lb) const {
+  if (loop_vert[la] != loop_vert[lb])
     return false;
   if (get_norm_idx(la) != get_norm_idx(lb))
     return false;
@@ -149,15 +69,15 @@ bool MeshOptimizer::splitable_edge(const Edge& e) const {
   if (!e.is_contiguous)
     return false;
   for (uint32_t vidx : e.verts) {
-    const Loop* found = nullptr;
+    uint32_t found = UINT32_MAX;
     for (uint32_t fidx : e.link_faces) {
       for (uint32_t lidx : faces[fidx].loops) {
-        if (loops[lidx].vert == vidx) {
-          if (!found) {
-            found = &loops[lidx];
+        if (loop_vert[lidx] == vidx) {
+          if (found == UINT32_MAX) {
+            found = lidx;
             break;
           } else {
-            if (!loops_contiguous(*found, loops[lidx]))
+            if (!loops_contiguous(found, lidx))
               return true;
             break;
           }
@@ -169,51 +89,202 @@ bool MeshOptimizer::splitable_edge(const Edge& e) const {
 }
 
 void MeshOptimizer::sort_faces_by_skin_group(std::vector<uint32_t>& sfaces) const {
-  std::vector<uint32_t> faces_out;
-  faces_out.reserve(sfaces.size());
-  std::unordered_set<uint32_t> done_sg;
-  uint32_t ref_sg = UINT32_MAX;
-  while (faces_out.size() < sfaces.size()) {
-    for (uint32_t f : sfaces) {
-      bool found = false;
-      for (uint32_t l : faces[f].loops) {
-        uint32_t skin_idx = get_skin_idx(verts[loops[l].vert]);
-        if (done_sg.find(skin_idx) == done_sg.end()) {
-          ref_sg = skin_idx;
-          done_sg.insert(skin_idx);
-          found = true;
-          break;
-        }
-      }
-      if (found)
-        break;
-    }
-    for (uint32_t f : sfaces) {
-      if (std::find(faces_out.begin(), faces_out.end(), f) != faces_out.end())
-        continue;
-      for (uint32_t l : faces[f].loops) {
-        uint32_t skin_idx = get_skin_idx(verts[loops[l].vert]);
-        if (skin_idx == ref_sg) {
-          faces_out.push_back(f);
-          break;
-        }
-      }
+  /* Skin groups are visited in order of first use; each face goes with the first visited
+   * group it uses, so rank groups by first use and bucket faces by their lowest rank */
+  const uint32_t no_skin_slot = uint32_t(b_skin.size());
+  std::vector<uint32_t> skin_rank(b_skin.size() + 1, UINT32_MAX);
+  std::vector<uint32_t> face_rank(sfaces.size());
+  uint32_t rank_count = 0;
+  for (size_t i = 0; i < sfaces.size(); ++i) {
+    uint32_t rank = UINT32_MAX;
+    for (uint32_t l : faces[sfaces[i]].loops) {
+      uint32_t skin_idx = get_skin_idx(loop_vert[l]);
+      uint32_t& skin_rank_ref = skin_rank[skin_idx == UINT32_MAX ? no_skin_slot : skin_idx];
+      if (skin_rank_ref == UINT32_MAX)
+        skin_rank_ref = rank_count++;
+      rank = std::min(rank, skin_rank_ref);
     }
+    face_rank[i] = rank;
   }
+
+  std::vector<uint32_t> rank_start(rank_count + 1, 0);
+  for (uint32_t rank : face_rank)
+    ++rank_start[rank + 1];
+  std::partial_sum(rank_start.begin(), rank_start.end(), rank_start.begin());
+  std::vector<uint32_t> faces_out(sfaces.size());
+  for (size_t i = 0; i < sfaces.size(); ++i)
+    faces_out[rank_start[face_rank[i]]++] = sfaces[i];
   sfaces = std::move(faces_out);
 }
 
 std::pair<uint32_t, uint32_t> MeshOptimizer::strip_next_loop(uint32_t prev_loop, uint32_t out_count) const {
   if (out_count & 0x1) {
-    uint32_t radial_loop = loops[prev_loop].link_loop_radial_next;
-    uint32_t loop = loops[radial_loop].link_loop_prev;
+    uint32_t radial_loop = loop_link_radial_next[prev_loop];
+    uint32_t loop = loop_link_prev[radial_loop];
     return {loop, loop};
   } else {
-    uint32_t radial_loop = loops[prev_loop].link_loop_radial_prev;
-    uint32_t loop = loops[radial_loop].link_loop_next;
-    return {loops[loop].link_loop_next, loop};
+    uint32_t radial_loop = loop_link_radial_prev[prev_loop];
+    uint32_t loop = loop_link_next[radial_loop];
+    return {loop_link_next[loop], loop};
+  }
+}
+
+namespace {
+/* Post-transform cache modelled for reordering and statistics */
+constexpr int VertexCacheSize = 32;
+
+float ForsythVertexScore(int cache_pos, uint32_t remaining) {
+  if (remaining == 0)
+    return -1.f;
+  float score = 0.f;
+  if (cache_pos >= 0) {
+    /* The last triangle's verts are scored flat so its neighbours don't win by default */
+    if (cache_pos < 3)
+      score = 0.75f;
+    else
+      score = std::pow(1.f - float(cache_pos - 3) / float(VertexCacheSize - 3), 1.5f);
+  }
+  /* Favour verts with few triangles left so they leave the mesh early */
+  return score + 2.f / std::sqrt(float(remaining));
+}
+
+/* Tom Forsyth's linear-speed vertex cache optimisation; returns triangles in emit order */
+std::vector<uint32_t> ForsythTriangleOrder(const std::vector<uint32_t>& indices, uint32_t vert_count) {
+  const uint32_t tri_count = uint32_t(indices.size() / 3);
+
+  /* Per-vertex lists of unemitted triangles; the first remaining[v] entries are live */
+  std::vector<uint32_t> tri_offset(vert_count + 1, 0);
+  for (uint32_t idx : indices)
+    ++tri_offset[idx + 1];
+  std::partial_sum(tri_offset.begin(), tri_offset.end(), tri_offset.begin());
+  std::vector<uint32_t> vert_tris(indices.size());
+  std::vector<uint32_t> remaining(vert_count, 0);
+  for (uint32_t t = 0; t < tri_count; ++t) {
+    for (uint32_t c = 0; c < 3; ++c) {
+      const uint32_t v = indices[t * 3 + c];
+      vert_tris[tri_offset[v] + remaining[v]++] = t;
+    }
+  }
+
+  std::vector<int> cache_pos(vert_count, -1);
+  std::vector<float> vert_score(vert_count);
+  for (uint32_t v = 0; v < vert_count; ++v)
+    vert_score[v] = ForsythVertexScore(-1, remaining[v]);
+  std::vector<float> tri_score(tri_count);
+  uint32_t best_tri = UINT32_MAX;
+  for (uint32_t t = 0; t < tri_count; ++t) {
+    tri_score[t] = vert_score[indices[t * 3]] + vert_score[indices[t * 3 + 1]] + vert_score[indices[t * 3 + 2]];
+    if (best_tri == UINT32_MAX || tri_score[t] > tri_score[best_tri])
+      best_tri = t;
+  }
+
+  std::vector<uint8_t> emitted(tri_count, 0);
+  std::vector<uint32_t> order;
+  order.reserve(tri_count);
+  std::vector<uint32_t> cache, new_cache;
+  cache.reserve(VertexCacheSize + 3);
+  new_cache.reserve(VertexCacheSize + 3);
+  uint32_t next_unemitted = 0;
+  while (order.size() < tri_count) {
+    if (best_tri == UINT32_MAX) {
+      /* Dead end; resume from the first triangle not yet emitted */
+      while (emitted[next_unemitted])
+        ++next_unemitted;
+      best_tri = next_unemitted;
+    }
+    const uint32_t t = best_tri;
+    emitted[t] = 1;
+    order.push_back(t);
+
+    /* Retire the triangle from its verts and move them to the front of the cache */
+    new_cache.clear();
+    for (uint32_t c = 0; c < 3; ++c) {
+      const uint32_t v = indices[t * 3 + c];
+      uint32_t* tris = vert_tris.data() + tri_offset[v];
+      std::swap(*std::find(tris, tris + remaining[v], t), tris[remaining[v] - 1]);
+      --remaining[v];
+      if (std::find(new_cache.begin(), new_cache.end(), v) == new_cache.end())
+        new_cache.push_back(v);
+    }
+    const std::size_t tri_verts = new_cache.size();
+    for (uint32_t v : cache)
+      if (std::find(new_cache.data(), new_cache.data() + tri_verts, v) == new_cache.data() + tri_verts)
+        new_cache.push_back(v);
+
+    /* Rescore everything whose cache position changed, including verts pushed out */
+    for (uint32_t i = 0; i < new_cache.size(); ++i) {
+      const uint32_t v = new_cache[i];
+      cache_pos[v] = i < VertexCacheSize ? int(i) : -1;
+      vert_score[v] = ForsythVertexScore(cache_pos[v], remaining[v]);
+    }
+    best_tri = UINT32_MAX;
+    for (uint32_t v : new_cache) {
+      const uint32_t* tris = vert_tris.data() + tri_offset[v];
+      for (uint32_t i = 0; i < remaining[v]; ++i) {
+        const uint32_t ot = tris[i];
+        tri_score[ot] =
+            vert_score[indices[ot * 3]] + vert_score[indices[ot * 3 + 1]] + vert_score[indices[ot * 3 + 2]];
+        if (best_tri == UINT32_MAX || tri_score[ot] > tri_score[best_tri])
+          best_tri = ot;
+      }
+    }
+
+    if (new_cache.size() > VertexCacheSize)
+      new_cache.resize(VertexCacheSize);
+    std::swap(cache, new_cache);
+  }
+  return order;
+}
+
+/* Average cache miss ratio (misses per triangle) and average transform to vertex ratio
+ * (misses per unique vertex) of a FIFO cache, the usual yardsticks for index order */
+void ReportCacheStats(const Mesh& mesh) {
+  std::size_t tri_count = 0;
+  std::size_t unique_count = 0;
+  std::size_t miss_count = 0;
+  std::unordered_map<Mesh::Surface::Vert, uint32_t> vert_ids;
+  std::vector<uint32_t> fifo;
+  std::vector<uint32_t> in_cache;
+  for (const Mesh::Surface& surf : mesh.surfaces) {
+    /* Each surface is its own draw, so the cache starts cold */
+    vert_ids.clear();
+    fifo.assign(VertexCacheSize, UINT32_MAX);
+    in_cache.clear();
+    std::size_t fifo_head = 0;
+    std::size_t strip_len = 0;
+    for (const Mesh::Surface::Vert& v : surf.verts) {
+      if (v.iPos == UINT32_MAX) {
+        strip_len = 0;
+        continue;
+      }
+      if (mesh.topology == HMDLTopology::TriStrips) {
+        if (++strip_len >= 3)
+          ++tri_count;
+      }
+      const auto [it, inserted] = vert_ids.try_emplace(v, uint32_t(vert_ids.size()));
+      const uint32_t id = it->second;
+      if (inserted)
+        in_cache.push_back(0);
+      if (!in_cache[id]) {
+        ++miss_count;
+        if (fifo[fifo_head] != UINT32_MAX)
+          in_cache[fifo[fifo_head]] = 0;
+        fifo[fifo_head] = id;
+        in_cache[id] = 1;
+        fifo_head = (fifo_head + 1) % VertexCacheSize;
+      }
+    }
+    if (mesh.topology == HMDLTopology::Triangles)
+      tri_count += surf.verts.size() / 3;
+    unique_count += vert_ids.size();
   }
+  if (!tri_count)
+    return;
+  Log.report(logvisor::Info, FMT_STRING("{} {} triangles: ACMR {:.3f}, ATVR {:.3f}"),
+             DataStream::MeshOutputModeString(mesh.topology), tri_count, float(miss_count) / float(tri_count),
+             float(miss_count) / float(unique_count));
 }
+} // namespace
 
 static float Magnitude(const Vector3f& v) { return std::sqrt(v.val.simd.dot3(v.val.simd)); }
 static void Normalize(Vector3f& v) {
@@ -221,7 +292,45 @@ static void Normalize(Vector3f& v) {
   v.val.simd *= athena::simd<float>(mag);
 }
 
-Mesh::Surface MeshOptimizer::generate_surface(std::vector<uint32_t>& island_faces, uint32_t mat_idx) const {
+Mesh::Surface::Vert MeshOptimizer::make_vert(uint32_t loop) const {
+  Mesh::Surface::Vert vert;
+  const uint32_t v = loop_vert[loop];
+  vert.iPos = get_pos_idx(v);
+  vert.iNorm = get_norm_idx(loop);
+  for (uint32_t i = 0; i < color_count; ++i)
+    vert.iColor[i] = get_color_idx(loop, i);
+  for (uint32_t i = 0; i < uv_count; ++i)
+    vert.iUv[i] = get_uv_idx(loop, i);
+  vert.iSkin = get_skin_idx(v);
+  return vert;
+}
+
+void MeshOptimizer::emit_triangles(Mesh::Surface& surf, const std::vector<uint32_t>& island_faces) const {
+  /* Corners with identical attributes become one VBO vertex, and so share a cache entry */
+  std::unordered_map<Mesh::Surface::Vert, uint32_t> vert_ids;
+  vert_ids.reserve(island_faces.size() * 3);
+  std::vector<Mesh::Surface::Vert> unique_verts;
+  std::vector<uint32_t> indices;
+  indices.reserve(island_faces.size() * 3);
+  for (uint32_t f : island_faces) {
+    for (uint32_t l : faces[f].loops) {
+      Mesh::Surface::Vert vert = make_vert(l);
+      const auto [it, inserted] = vert_ids.try_emplace(vert, uint32_t(unique_verts.size()));
+      if (inserted)
+        unique_verts.push_back(vert);
+      indices.push_back(it->second);
+    }
+  }
+
+  /* getHMDLBuffers pools verts in first-use order, so this also orders vertex fetches */
+  surf.verts.reserve(indices.size());
+  for (uint32_t t : ForsythTriangleOrder(indices, uint32_t(unique_verts.size())))
+    for (uint32_t c = 0; c < 3; ++c)
+      surf.verts.push_back(unique_verts[indices[t * 3 + c]]);
+}
+
+Mesh::Surface MeshOptimizer::generate_surface(std::vector<uint32_t>& island_faces, uint32_t mat_idx,
+                                              HMDLTopology topology) const {
   Mesh::Surface ret = {};
   ret.materialIdx = mat_idx;
 
@@ -235,12 +344,12 @@ Mesh::Surface MeshOptimizer::generate_surface(std::vector<uint32_t>& island_face
   ret.aabbMax.val.simd = athena::simd<float>(-FLT_MAX);
   for (const auto& f : island_faces) {
     for (const auto l : faces[f].loops) {
-      const Vertex& v = verts[loops[l].vert];
+      const Vector3f& co = vert_co[loop_vert[l]];
       for (int c = 0; c < 3; ++c) {
-        if (v.co.val.simd[c] < ret.aabbMin.val.simd[c])
-          ret.aabbMin.val.simd[c] = v.co.val.simd[c];
-        if (v.co.val.simd[c] > ret.aabbMax.val.simd[c])
-          ret.aabbMax.val.simd[c] = v.co.val.simd[c];
+        if (co.val.simd[c] < ret.aabbMin.val.simd[c])
+          ret.aabbMin.val.simd[c] = co.val.simd[c];
+        if (co.val.simd[c] > ret.aabbMax.val.simd[c])
+          ret.aabbMax.val.simd[c] = co.val.simd[c];
       }
     }
   }
@@ -250,82 +359,231 @@ Mesh::Surface MeshOptimizer::generate_surface(std::vector<uint32_t>& island_face
     ret.reflectionNormal.val.simd += faces[f].normal.val.simd;
   Normalize(ret.reflectionNormal);
 
-  /* Verts themselves */
-  uint32_t prev_loop_emit = UINT32_MAX;
-  std::vector<std::pair<std::vector<uint32_t>, std::vector<uint32_t>>> sel_lists_local;
-  sel_lists_local.reserve(loops.size());
-  while (island_faces.size()) {
-    sel_lists_local.clear();
-    for (uint32_t start_face : island_faces) {
-      for (uint32_t l : faces[start_face].loops) {
-        std::vector<uint32_t> island_local(island_faces);
-        uint32_t prev_loop = loops[l].link_loop_next;
-        uint32_t loop = loops[prev_loop].link_loop_next;
-        std::vector<uint32_t> sel_list;
-        sel_list.reserve(64);
-        sel_list.push_back(l);
-        sel_list.push_back(prev_loop);
-        sel_list.push_back(loop);
-        island_local.erase(std::find(island_local.begin(), island_local.end(), start_face));
-        while (true) {
-          const Edge& prev_edge = edges[loops[prev_loop].edge];
-          if (!prev_edge.is_contiguous || prev_edge.tag)
-            break;
-          std::tie(loop, prev_loop) = strip_next_loop(prev_loop, sel_list.size());
-          uint32_t face = loops[loop].face;
-          auto search = std::find(island_local.begin(), island_local.end(), face);
-          if (search == island_local.end())
-            break;
-          sel_list.push_back(loop);
-          island_local.erase(search);
-        }
-        sel_lists_local.emplace_back(std::move(sel_list), std::move(island_local));
+  if (topology == HMDLTopology::Triangles) {
+    emit_triangles(ret, island_faces);
+    island_faces.clear();
+    return ret;
+  }
+
+  /* Index faces within the island */
+  const uint32_t island_size = uint32_t(island_faces.size());
+  std::unordered_map<uint32_t, uint32_t> island_idx;
+  island_idx.reserve(island_size);
+  for (uint32_t i = 0; i < island_size; ++i)
+    island_idx[island_faces[i]] = i;
+  auto local_face = [&](uint32_t face) {
+    auto search = island_idx.find(face);
+    return search != island_idx.cend() ? search->second : UINT32_MAX;
+  };
+
+  /* Faces a strip may continue into across each edge; valence counts those not yet stripped */
+  std::vector<std::array<uint32_t, 3>> adjacent(island_size);
+  std::vector<uint8_t> valence(island_size, 0);
+  for (uint32_t i = 0; i < island_size; ++i) {
+    uint32_t j = 0;
+    for (uint32_t l : faces[island_faces[i]].loops) {
+      uint32_t adj = UINT32_MAX;
+      const Edge& edge = edges[loop_edge[l]];
+      if (edge.is_contiguous && !edge.tag)
+        adj = local_face(loop_face[loop_link_radial_next[l]]);
+      if (adj == i)
+        adj = UINT32_MAX;
+      adjacent[i][j++] = adj;
+      if (adj != UINT32_MAX)
+        ++valence[i];
+    }
+  }
+
+  /* Bucket queue by valence; entries go stale when their face is used or its valence drops */
+  std::array<std::vector<uint32_t>, 4> start_buckets;
+  for (uint32_t i = island_size; i-- > 0;)
+    start_buckets[valence[i]].push_back(i);
+  std::vector<uint8_t> used(island_size, 0);
+  auto pop_start_face = [&]() {
+    for (uint32_t v = 0; v < start_buckets.size(); ++v) {
+      auto& bucket = start_buckets[v];
+      while (!bucket.empty()) {
+        const uint32_t f = bucket.back();
+        bucket.pop_back();
+        if (!used[f] && valence[f] == v)
+          return f;
       }
     }
-    uint32_t max_count = 0;
-    const std::vector<uint32_t>* max_sl = nullptr;
-    const std::vector<uint32_t>* max_island_faces = nullptr;
-    for (const auto& sl : sel_lists_local) {
-      if (sl.first.size() > max_count) {
-        max_count = sl.first.size();
-        max_sl = &sl.first;
-        max_island_faces = &sl.second;
+    return UINT32_MAX;
+  };
+
+  /* Walk a strip whose first triangle is start_face entered at loop l. With parity set the walk
+   * turns the opposite way at each face, tracing the strip that would lead into l backwards. */
+  std::vector<uint32_t> visit_stamp(island_size, 0);
+  uint32_t cur_stamp = 0;
+  auto walk_strip = [&](uint32_t start_face, uint32_t l, uint32_t parity, std::vector<uint32_t>& sel_list,
+                        std::vector<uint32_t>& sel_faces) {
+    sel_list.clear();
+    sel_faces.clear();
+    uint32_t prev_loop = loop_link_next[l];
+    uint32_t loop = loop_link_next[prev_loop];
+    sel_list.push_back(l);
+    sel_list.push_back(prev_loop);
+    sel_list.push_back(loop);
+    sel_faces.push_back(start_face);
+    visit_stamp[start_face] = cur_stamp;
+    while (true) {
+      const Edge& prev_edge = edges[loop_edge[prev_loop]];
+      if (!prev_edge.is_contiguous || prev_edge.tag)
+        break;
+      std::tie(loop, prev_loop) = strip_next_loop(prev_loop, sel_list.size() + parity);
+      const uint32_t face = local_face(loop_face[loop]);
+      if (face == UINT32_MAX || used[face] || visit_stamp[face] == cur_stamp)
+        break;
+      visit_stamp[face] = cur_stamp;
+      sel_list.push_back(loop);
+      sel_faces.push_back(face);
+    }
+  };
+
+  /* Verts themselves; strips start from the faces with the fewest unstripped neighbours
+   * so those aren't stranded. Each of the three winding directions is walked forward and
+   * then backward across the start face's leading edge, keeping the longest strip. */
+  std::vector<uint32_t> fwd_list, fwd_faces, back_list, back_faces, best_list, best_faces;
+  uint32_t prev_loop_emit = UINT32_MAX;
+  for (uint32_t start_face = pop_start_face(); start_face != UINT32_MAX; start_face = pop_start_face()) {
+    best_list.clear();
+    best_faces.clear();
+    for (uint32_t l : faces[island_faces[start_face]].loops) {
+      ++cur_stamp;
+      walk_strip(start_face, l, 0, fwd_list, fwd_faces);
+      walk_strip(start_face, loop_link_prev[l], 1, back_list, back_faces);
+
+      /* Backward faces precede the start face; keep an even count so it stays front-facing */
+      size_t back_count = back_faces.size() - 1;
+      back_count &= ~size_t(1);
+      if (fwd_faces.size() + back_count <= best_faces.size())
+        continue;
+      best_list.assign(back_list.begin() + 3, back_list.begin() + 3 + back_count);
+      std::reverse(best_list.begin(), best_list.end());
+      best_list.insert(best_list.end(), fwd_list.begin(), fwd_list.end());
+      best_faces.assign(back_faces.begin() + 1, back_faces.begin() + 1 + back_count);
+      best_faces.insert(best_faces.end(), fwd_faces.begin(), fwd_faces.end());
+    }
+
+    for (uint32_t f : best_faces)
+      used[f] = 1;
+    for (uint32_t f : best_faces) {
+      for (uint32_t adj : adjacent[f]) {
+        if (adj != UINT32_MAX && !used[adj])
+          start_buckets[--valence[adj]].push_back(adj);
       }
     }
-    assert(max_island_faces && "Should not be null");
-    assert(max_island_faces->size() < island_faces.size() && "Infinite loop condition");
-    island_faces = std::move(*max_island_faces);
+
     if (prev_loop_emit != UINT32_MAX)
       ret.verts.emplace_back();
-    for (uint32_t loop : *max_sl) {
-      ret.verts.emplace_back();
-      const auto& l = loops[loop];
-      auto& vert = ret.verts.back();
-      vert.iPos = get_pos_idx(verts[l.vert]);
-      vert.iNorm = get_norm_idx(l);
-      for (uint32_t i = 0; i < color_count; ++i)
-        vert.iColor[i] = get_color_idx(l, i);
-      for (uint32_t i = 0; i < uv_count; ++i)
-        vert.iUv[i] = get_uv_idx(l, i);
-      vert.iSkin = get_skin_idx(verts[l.vert]);
+    for (uint32_t loop : best_list) {
+      ret.verts.push_back(make_vert(loop));
       prev_loop_emit = loop;
     }
   }
+  island_faces.clear();
 
   return ret;
 }
 
+void MeshOptimizer::generate_material_surfaces(std::vector<uint32_t> mat_faces_rem, uint32_t mat_idx,
+                                               int max_skin_banks, HMDLTopology topology,
+                                               std::vector<Mesh::Surface>& out) const {
+  if (b_skin.size())
+    sort_faces_by_skin_group(mat_faces_rem);
+  std::vector<uint32_t> the_list;
+  the_list.reserve(mat_faces_rem.size());
+  std::unordered_set<uint32_t> skin_slot_set;
+  size_t rem_count = mat_faces_rem.size();
+  while (rem_count) {
+    the_list.clear();
+    skin_slot_set.clear();
+    for (uint32_t& f : mat_faces_rem) {
+      if (f == UINT32_MAX)
+        continue;
+      if (b_skin.size()) {
+        bool brk = false;
+        for (const auto l : faces[f].loops) {
+          uint32_t skin_idx = get_skin_idx(loop_vert[l]);
+          if (skin_slot_set.find(skin_idx) == skin_slot_set.end()) {
+            if (max_skin_banks > 0 && skin_slot_set.size() == size_t(max_skin_banks)) {
+              brk = true;
+              break;
+            }
+            skin_slot_set.insert(skin_idx);
+          }
+        }
+        if (brk)
+          break;
+      }
+      the_list.push_back(f);
+      f = UINT32_MAX;
+      --rem_count;
+    }
+    out.push_back(generate_surface(the_list, mat_idx, topology));
+  }
+}
+
+namespace {
+/* Lends the rest of a mesh's surface generation to idle ClientProcess workers. The calling
+ * worker keeps generating too, so helpers queued behind busy workers may start only after
+ * the work is gone; they then return at once. */
+class GenerationHelpers {
+  struct State {
+    std::mutex lock;
+    std::condition_variable cv;
+    const std::function<void()>* proc;
+    int running = 0;
+  };
+  std::shared_ptr<State> m_state;
+
+public:
+  explicit GenerationHelpers(const std::function<void()>& proc) : m_state(std::make_shared<State>()) {
+    m_state->proc = &proc;
+  }
+
+  /** Queue up to count helpers on the calling thread's ClientProcess, if it has one */
+  void request(size_t count) {
+    ClientProcess* cp = ClientProcess::GetThreadClientProcess();
+    if (!cp)
+      return;
+    count = std::min(count, size_t(cp->getWorkerCount() - 1));
+    for (size_t i = 0; i < count; ++i) {
+      cp->addLambdaTransaction([state = m_state](blender::Token&) {
+        std::unique_lock lk{state->lock};
+        if (!state->proc)
+          return;
+        const std::function<void()>& proc = *state->proc;
+        ++state->running;
+        lk.unlock();
+        proc();
+        lk.lock();
+        if (--state->running == 0)
+          state->cv.notify_all();
+      });
+    }
+  }
+
+  /** Waits out helpers still finishing a material; later ones find nothing to do */
+  ~GenerationHelpers() {
+    std::unique_lock lk{m_state->lock};
+    m_state->proc = nullptr;
+    m_state->cv.wait(lk, [&]() { return m_state->running == 0; });
+  }
+};
+} // namespace
+
 void MeshOptimizer::optimize(Mesh& mesh, int max_skin_banks) const {
-  mesh.topology = HMDLTopology::TriStrips;
 
-  mesh.pos = sort_unordered_map(b_pos);
-  mesh.norm = sort_unordered_map(b_norm);
+  mesh.pos = b_pos.values();
+  mesh.norm = b_norm.values();
   mesh.colorLayerCount = color_count;
-  mesh.color = sort_unordered_map(b_color);
+  mesh.color = b_color.values();
   mesh.uvLayerCount = uv_count;
-  mesh.uv = sort_unordered_map(b_uv);
-  mesh.luv = sort_unordered_map(b_luv);
-  mesh.skins = sort_unordered_map(b_skin);
+  mesh.uv = b_uv.values();
+  mesh.luv = b_luv.values();
+  mesh.skins = b_skin.values();
 
   /* Sort materials by pass index */
   std::vector<uint32_t> sorted_material_idxs(materials.size());
@@ -333,55 +591,254 @@ void MeshOptimizer::optimize(Mesh& mesh, int max_skin_banks) const {
   std::sort(sorted_material_idxs.begin(), sorted_material_idxs.end(),
   [this](uint32_t a, uint32_t b) { return materials[a].passIndex < materials[b].passIndex; });
 
-  /* Generate island surfaces */
-  std::vector<uint32_t> mat_faces_rem, the_list;
-  mat_faces_rem.reserve(faces.size());
-  the_list.reserve(faces.size());
-  std::unordered_set<uint32_t> skin_slot_set;
-  skin_slot_set.reserve(b_skin.size());
-  for (uint32_t mat_idx : sorted_material_idxs) {
-    const auto& mat = materials[mat_idx];
-    mat_faces_rem.clear();
-    for (auto B = faces.begin(), I = B, E = faces.end(); I != E; ++I) {
-      if (I->material_index == mat_idx)
-        mat_faces_rem.push_back(I - B);
+  /* Bucket faces by material, keeping face order within each */
+  std::vector<std::vector<uint32_t>> mat_faces(materials.size());
+  for (uint32_t f = 0; f < faces.size(); ++f) {
+    if (faces[f].material_index < materials.size())
+      mat_faces[faces[f].material_index].push_back(f);
+  }
+
+  /* Materials are independent until merged; heavy meshes spread them across threads,
+   * largest first, and surfaces are concatenated in pass order regardless */
+  std::vector<std::vector<Mesh::Surface>> mat_surfaces(materials.size());
+  std::vector<uint32_t> schedule(sorted_material_idxs);
+  std::stable_sort(schedule.begin(), schedule.end(),
+                   [&](uint32_t a, uint32_t b) { return mat_faces[a].size() > mat_faces[b].size(); });
+  std::atomic_size_t next_mat = 0;
+  const std::function<void()> generate_proc = [&]() {
+    for (size_t i; (i = next_mat++) < schedule.size();) {
+      const uint32_t mat_idx = schedule[i];
+      generate_material_surfaces(std::move(mat_faces[mat_idx]), mat_idx, max_skin_banks, mesh.topology,
+                                 mat_surfaces[mat_idx]);
     }
-    if (b_skin.size())
-      sort_faces_by_skin_group(mat_faces_rem);
-    size_t rem_count = mat_faces_rem.size();
-    while (rem_count) {
-      the_list.clear();
-      skin_slot_set.clear();
-      for (uint32_t& f : mat_faces_rem) {
-        if (f == UINT32_MAX)
-          continue;
-        if (b_skin.size()) {
-          bool brk = false;
-          for (const auto l : faces[f].loops) {
-            const Vertex& v = verts[loops[l].vert];
-            uint32_t skin_idx = get_skin_idx(v);
-            if (skin_slot_set.find(skin_idx) == skin_slot_set.end()) {
-              if (max_skin_banks > 0 && skin_slot_set.size() == size_t(max_skin_banks)) {
-                brk = true;
-                break;
-              }
-              skin_slot_set.insert(skin_idx);
-            }
-          }
-          if (brk)
-            break;
-        }
-        the_list.push_back(f);
-        f = UINT32_MAX;
-        --rem_count;
+  };
+  {
+    /* Helpers come from the cook's own worker pool, so a heavy mesh never takes more CPUs
+     * than the pool has, however many workers are compiling meshes at once */
+    GenerationHelpers helpers(generate_proc);
+    if (faces.size() >= ParallelFaceThreshold)
+      helpers.request(schedule.size() - 1);
+    generate_proc();
+  }
+
+  for (uint32_t mat_idx : sorted_material_idxs)
+    for (Mesh::Surface& surf : mat_surfaces[mat_idx])
+      mesh.surfaces.push_back(std::move(surf));
+
+  if (hecl::VerbosityLevel >= 1)
+    ReportCacheStats(mesh);
+}
+
+template <typename T>
+void MeshOptimizer::read_column(Connection& conn, std::vector<T>& out, uint32_t count, size_t packed_size) {
+  out.resize(count);
+  const uint8_t* data = conn._beginBulk(count * packed_size);
+  if (packed_size == sizeof(T)) {
+    std::memcpy(out.data(), data, count * packed_size);
+  } else {
+    /* Packed vectors expand into the padded attribute types */
+    for (uint32_t i = 0; i < count; ++i)
+      std::memcpy(&out[i], data + i * packed_size, packed_size);
+  }
+  conn._endBulk();
+}
+
+void MeshOptimizer::read_verts(Connection& conn) {
+  uint32_t vert_count;
+  conn._readValue(vert_count);
+  read_column(conn, vert_co, vert_count, 12);
+
+  std::vector<uint32_t> skin_counts;
+  read_column(conn, skin_counts, vert_count);
+  uint32_t bind_count;
+  conn._readValue(bind_count);
+  std::vector<Mesh::SkinBind> binds;
+  read_column(conn, binds, bind_count, 8);
+  if (!bind_count)
+    return;
+
+  vert_skins.resize(vert_count);
+  size_t bind_idx = 0;
+  for (uint32_t i = 0; i < vert_count; ++i) {
+    const uint32_t skin_count = skin_counts[i];
+    if (skin_count > MaxSkinEntries)
+      Log.report(logvisor::Fatal, FMT_STRING("Skin entry overflow {}/{}"), skin_count, MaxSkinEntries);
+    if (bind_idx + skin_count > binds.size())
+      Log.report(logvisor::Fatal, FMT_STRING("Skin bind overflow {}/{}"), bind_idx + skin_count, binds.size());
+    std::copy(binds.begin() + bind_idx, binds.begin() + bind_idx + skin_count, vert_skins[i].begin());
+    bind_idx += skin_count;
+  }
+}
+
+void MeshOptimizer::read_faces(Connection& conn) {
+  uint32_t face_count;
+  conn._readValue(face_count);
+  faces.resize(face_count);
+
+  std::vector<Vector3f> vecs;
+  read_column(conn, vecs, face_count, 12);
+  for (uint32_t i = 0; i < face_count; ++i)
+    faces[i].normal = vecs[i];
+  read_column(conn, vecs, face_count, 12);
+  for (uint32_t i = 0; i < face_count; ++i)
+    faces[i].centroid = vecs[i];
+
+  std::vector<uint32_t> idxs;
+  read_column(conn, idxs, face_count);
+  for (uint32_t i = 0; i < face_count; ++i)
+    faces[i].material_index = idxs[i];
+  read_column(conn, idxs, face_count * 3);
+  for (uint32_t i = 0; i < face_count; ++i)
+    for (uint32_t j = 0; j < 3; ++j)
+      faces[i].loops[j] = idxs[i * 3 + j];
+}
+
+/* Runs each dedup stage once the main thread has read the columns it consumes. Every pool
+ * has a single inserter, so indices match those of a sequential read. */
+class MeshOptimizer::DedupPipeline {
+  std::mutex m_lock;
+  std::condition_variable m_cv;
+  uint32_t m_ready = 0;
+  std::thread m_thread;
+
+  void wait(DedupStage stage) {
+    std::unique_lock lk{m_lock};
+    m_cv.wait(lk, [&]() { return m_ready > uint32_t(stage); });
+  }
+
+public:
+  explicit DedupPipeline(MeshOptimizer& opt) {
+    m_thread = std::thread([this, &opt]() {
+      for (DedupStage stage : {DedupStage::Verts, DedupStage::Normals, DedupStage::Colors, DedupStage::UVs}) {
+        wait(stage);
+        opt.dedup(stage);
       }
-      mesh.surfaces.push_back(generate_surface(the_list, mat_idx));
+    });
+  }
+  ~DedupPipeline() { join(); }
+
+  /** Columns consumed by stage have been read */
+  void advance(DedupStage stage) {
+    {
+      std::unique_lock lk{m_lock};
+      m_ready = uint32_t(stage) + 1;
+    }
+    m_cv.notify_one();
+  }
+
+  void join() {
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+};
+
+void MeshOptimizer::read_loops(Connection& conn, DedupPipeline* pipeline) {
+  uint32_t loop_count;
+  conn._readValue(loop_count);
+  read_column(conn, loop_normal, loop_count, 12);
+  if (pipeline)
+    pipeline->advance(DedupStage::Normals);
+  for (uint32_t i = 0; i < color_count; ++i)
+    read_column(conn, loop_colors[i], loop_count, 12);
+  if (pipeline)
+    pipeline->advance(DedupStage::Colors);
+  for (uint32_t i = 0; i < uv_count; ++i)
+    read_column(conn, loop_uvs[i], loop_count, 8);
+  read_column(conn, loop_vert, loop_count);
+  read_column(conn, loop_edge, loop_count);
+  read_column(conn, loop_face, loop_count);
+  if (pipeline)
+    pipeline->advance(DedupStage::UVs);
+  read_column(conn, loop_link_next, loop_count);
+  read_column(conn, loop_link_prev, loop_count);
+  read_column(conn, loop_link_radial_next, loop_count);
+  read_column(conn, loop_link_radial_prev, loop_count);
+}
+
+void MeshOptimizer::read_edges(Connection& conn) {
+  uint32_t edge_count;
+  conn._readValue(edge_count);
+  edges.resize(edge_count);
+
+  std::vector<uint32_t> idxs;
+  read_column(conn, idxs, edge_count * 2);
+  for (uint32_t i = 0; i < edge_count; ++i)
+    for (uint32_t j = 0; j < 2; ++j)
+      edges[i].verts[j] = idxs[i * 2 + j];
+
+  std::vector<uint32_t> face_counts;
+  read_column(conn, face_counts, edge_count);
+  uint32_t link_count;
+  conn._readValue(link_count);
+  read_column(conn, idxs, link_count);
+  size_t link_idx = 0;
+  for (uint32_t i = 0; i < edge_count; ++i) {
+    const uint32_t face_count = face_counts[i];
+    if (face_count > Edge::MaxLinkFaces)
+      Log.report(logvisor::Fatal, FMT_STRING("Face overflow {}/{}"), face_count, Edge::MaxLinkFaces);
+    if (link_idx + face_count > idxs.size())
+      Log.report(logvisor::Fatal, FMT_STRING("Edge face overflow {}/{}"), link_idx + face_count, idxs.size());
+    for (uint32_t j = 0; j < face_count; ++j)
+      edges[i].link_faces[j] = idxs[link_idx++];
+  }
+
+  std::vector<uint8_t> contiguous;
+  read_column(conn, contiguous, edge_count);
+  for (uint32_t i = 0; i < edge_count; ++i)
+    edges[i].is_contiguous = contiguous[i] != 0;
+}
+
+void MeshOptimizer::dedup(DedupStage stage) {
+  /* The normal column is the first loop column read; later ones may still be arriving.
+   * Verts run while the loop columns are still being sized, so they must not touch them. */
+  const size_t loop_count = stage != DedupStage::Verts ? loop_normal.size() : 0;
+  switch (stage) {
+  case DedupStage::Verts:
+    b_pos.reserve(vert_co.size());
+    for (const Vector3f& co : vert_co)
+      b_pos.insert(co);
+    if (!vert_skins.empty()) {
+      b_skin.reserve(vert_co.size());
+      for (const auto& skin : vert_skins)
+        if (skin[0].valid())
+          b_skin.insert(skin);
     }
+    break;
+  case DedupStage::Normals:
+    b_norm.reserve(loop_count);
+    for (const Vector3f& normal : loop_normal)
+      b_norm.insert(normal);
+    break;
+  case DedupStage::Colors:
+    b_color.reserve(loop_count * color_count);
+    for (size_t i = 0; i < loop_count; ++i)
+      for (uint32_t c = 0; c < color_count; ++c)
+        b_color.insert(loop_colors[c][i]);
+    break;
+  case DedupStage::UVs:
+    b_uv.reserve(loop_count * uv_count);
+    if (use_luvs)
+      b_luv.reserve(loop_count);
+    for (uint32_t i = 0; i < loop_count; ++i) {
+      const bool luv = loop_uses_luv(i);
+      if (luv)
+        b_luv.insert(loop_uvs[0][i]);
+      for (uint32_t u = luv ? 1 : 0; u < uv_count; ++u)
+        b_uv.insert(loop_uvs[u][i]);
+    }
+    break;
   }
 }
 
 MeshOptimizer::MeshOptimizer(Connection& conn, const std::vector<Material>& materials, bool use_luvs)
 : materials(materials), use_luvs(use_luvs) {
+  uint32_t version;
+  conn._readValue(version);
+  if (version != FormatVersion)
+    Log.report(logvisor::Fatal,
+               FMT_STRING("Mesh format version {} does not match expected {}; reinstall the hecl addon"), version,
+               FormatVersion);
+
   conn._readValue(color_count);
   if (color_count > MaxColorLayers)
     Log.report(logvisor::Fatal, FMT_STRING("Color layer overflow {}/{}"), color_count, MaxColorLayers);
@@ -389,47 +846,23 @@ MeshOptimizer::MeshOptimizer(Connection& conn, const std::vector<Material>& mate
   if (uv_count > MaxUVLayers)
     Log.report(logvisor::Fatal, FMT_STRING("UV layer overflow {}/{}"), uv_count, MaxUVLayers);
 
-  /* Simultaneously load topology objects and build unique mapping indices */
-
-  uint32_t vert_count;
-  conn._readValue(vert_count);
-  verts.reserve(vert_count);
-  b_pos.reserve(vert_count);
-  b_skin.reserve(vert_count * 4);
-  for (uint32_t i = 0; i < vert_count; ++i) {
-    verts.emplace_back(conn);
-    insert_unique_attr(b_pos, verts.back().co);
-    if (verts.back().skin_ents[0].valid())
-      insert_unique_attr(b_skin, verts.back().skin_ents);
+  /* Faces precede loops so lightmap UV classification can consult face materials.
+   * Heavy meshes dedup attributes while the remaining columns are still streaming in. */
+  read_verts(conn);
+  std::unique_ptr<DedupPipeline> pipeline;
+  if (vert_co.size() >= PipelineVertThreshold) {
+    pipeline = std::make_unique<DedupPipeline>(*this);
+    pipeline->advance(DedupStage::Verts);
   }
-
-  uint32_t loop_count;
-  conn._readValue(loop_count);
-  loops.reserve(loop_count);
-  b_norm.reserve(loop_count);
-  if (use_luvs) {
-    b_uv.reserve(std::max(int(loop_count) - 1, 0) * uv_count);
-    b_luv.reserve(loop_count);
+  read_faces(conn);
+  read_loops(conn, pipeline.get());
+  read_edges(conn);
+  if (pipeline) {
+    pipeline->join();
   } else {
-    b_uv.reserve(loop_count * uv_count);
+    for (DedupStage stage : {DedupStage::Verts, DedupStage::Normals, DedupStage::Colors, DedupStage::UVs})
+      dedup(stage);
   }
-  for (uint32_t i = 0; i < loop_count; ++i) {
-    loops.emplace_back(conn, color_count, uv_count);
-    insert_unique_attr(b_norm, loops.back().normal);
-    for (const auto& c : loops.back().colors)
-      insert_unique_attr(b_color, c);
-    if (use_luvs && material_is_lightmapped(materials[faces[loops.back().face].material_index])) {
-      insert_unique_attr(b_luv, loops.back().uvs[0]);
-      for (auto I = std::begin(loops.back().uvs) + 1, E = std::end(loops.back().uvs); I != E; ++I)
-        insert_unique_attr(b_uv, *I);
-    } else {
-      for (const auto& c : loops.back().uvs)
-        insert_unique_attr(b_uv, c);
-    }
-  }
-
-  conn._readVector(edges);
-  conn._readVector(faces);
 
   /* Cache edges that should block tristrip traversal */
   for (auto& e : edges)
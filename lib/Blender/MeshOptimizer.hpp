@@ -38,38 +38,109 @@ public:
   size_t size() const { return end() - begin(); }
 };
 
+/**
+ * @brief Insertion-ordered set of attribute values with open-addressing lookup
+ *
+ * Values are stored densely in the order first inserted, so a value's index is final
+ * as soon as it is inserted and values() is directly usable as the attribute array.
+ */
+template <typename T, typename Hash = std::hash<T>>
+class AttrPool {
+  std::vector<T> m_values;
+  std::vector<uint32_t> m_slots; /* indices into m_values, UINT32_MAX when empty */
+  uint32_t m_shift = 64;
+
+  size_t slot_of(const T& value) const {
+    /* Fibonacci hashing spreads the weak low bits of std::hash over the table */
+    return size_t((uint64_t(Hash()(value)) * 0x9E3779B97F4A7C15ULL) >> m_shift);
+  }
+
+  void rehash(size_t capacity) {
+    uint32_t bits = 3;
+    while ((size_t(1) << bits) < capacity * 2)
+      ++bits;
+    m_shift = 64 - bits;
+    m_slots.assign(size_t(1) << bits, UINT32_MAX);
+    const size_t mask = m_slots.size() - 1;
+    for (uint32_t i = 0; i < m_values.size(); ++i) {
+      size_t slot = slot_of(m_values[i]);
+      while (m_slots[slot] != UINT32_MAX)
+        slot = (slot + 1) & mask;
+      m_slots[slot] = i;
+    }
+  }
+
+public:
+  /** Size for count values without rehashing; keeps the load factor at or below one half */
+  void reserve(size_t count) {
+    m_values.reserve(count);
+    if (count * 2 > m_slots.size())
+      rehash(count);
+  }
+
+  /** @return index of value, inserting it if not already present */
+  uint32_t insert(const T& value) {
+    if ((m_values.size() + 1) * 2 > m_slots.size())
+      rehash(std::max(m_values.size() + 1, m_values.size() * 2));
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = slot_of(value);; slot = (slot + 1) & mask) {
+      const uint32_t idx = m_slots[slot];
+      if (idx == UINT32_MAX) {
+        m_slots[slot] = uint32_t(m_values.size());
+        m_values.push_back(value);
+        return m_slots[slot];
+      }
+      if (m_values[idx] == value)
+        return idx;
+    }
+  }
+
+  /** @return index of value, or UINT32_MAX if not present */
+  uint32_t find(const T& value) const {
+    if (m_slots.empty())
+      return UINT32_MAX;
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = slot_of(value);; slot = (slot + 1) & mask) {
+      const uint32_t idx = m_slots[slot];
+      if (idx == UINT32_MAX || m_values[idx] == value)
+        return idx;
+    }
+  }
+
+  size_t size() const { return m_values.size(); }
+  const std::vector<T>& values() const { return m_values; }
+};
+
 class MeshOptimizer {
+  friend struct MeshOptimizerBench; /* hecl-bench times the internal passes */
   static constexpr size_t MaxColorLayers = Mesh::MaxColorLayers;
   static constexpr size_t MaxUVLayers = Mesh::MaxUVLayers;
   static constexpr size_t MaxSkinEntries = Mesh::MaxSkinEntries;
 
+  /** Version of the columnar MESHCOMPILE layout written by HMDLMesh.write_mesh_attrs */
+  static constexpr uint32_t FormatVersion = 2;
+
   const std::vector<Material>& materials;
   bool use_luvs;
 
   uint32_t color_count;
   uint32_t uv_count;
 
-  struct Vertex {
-    Vector3f co = {};
-    std::array<Mesh::SkinBind, MaxSkinEntries> skin_ents = {};
-    explicit Vertex(Connection& conn);
-  };
-  std::vector<Vertex> verts;
-
-  struct Loop {
-    Vector3f normal = {};
-    std::array<Vector3f, MaxColorLayers> colors = {};
-    std::array<Vector2f, MaxUVLayers> uvs = {};
-    uint32_t vert = UINT32_MAX;
-    uint32_t edge = UINT32_MAX;
-    uint32_t face = UINT32_MAX;
-    uint32_t link_loop_next = UINT32_MAX;
-    uint32_t link_loop_prev = UINT32_MAX;
-    uint32_t link_loop_radial_next = UINT32_MAX;
-    uint32_t link_loop_radial_prev = UINT32_MAX;
-    explicit Loop(Connection& conn, uint32_t color_count, uint32_t uv_count);
-  };
-  std::vector<Loop> loops;
+  /* Vertex attributes, one array per attribute; skins is empty for unskinned meshes */
+  std::vector<Vector3f> vert_co;
+  std::vector<std::array<Mesh::SkinBind, MaxSkinEntries>> vert_skins;
+
+  /* Loop attributes; only the first color_count/uv_count layers are populated */
+  std::vector<Vector3f> loop_normal;
+  std::array<std::vector<Vector3f>, MaxColorLayers> loop_colors;
+  std::array<std::vector<Vector2f>, MaxUVLayers> loop_uvs;
+  std::vector<uint32_t> loop_vert;
+  std::vector<uint32_t> loop_edge;
+  std::vector<uint32_t> loop_face;
+  std::vector<uint32_t> loop_link_next;
+  std::vector<uint32_t> loop_link_prev;
+  std::vector<uint32_t> loop_link_radial_next;
+  std::vector<uint32_t> loop_link_radial_prev;
 
   struct Edge {
     static constexpr size_t MaxLinkFaces = 8;
@@ -77,7 +148,6 @@ class MeshOptimizer {
     IndexArray<MaxLinkFaces> link_faces;
     bool is_contiguous = false;
     bool tag = false;
-    explicit Edge(Connection& conn);
   };
   std::vector<Edge> edges;
 
@@ -86,32 +156,68 @@ class MeshOptimizer {
     Vector3f centroid = {};
     uint32_t material_index = UINT32_MAX;
     IndexArray<3> loops;
-    explicit Face(Connection& conn);
   };
   std::vector<Face> faces;
 
-  std::unordered_map<Vector3f, uint32_t> b_pos;
-  std::unordered_map<Vector3f, uint32_t> b_norm;
-  std::unordered_map<std::array<Mesh::SkinBind, MaxSkinEntries>, uint32_t> b_skin;
-  std::unordered_map<Vector3f, uint32_t> b_color;
-  std::unordered_map<Vector2f, uint32_t> b_uv;
-  std::unordered_map<Vector2f, uint32_t> b_luv;
-
-  uint32_t get_pos_idx(const Vertex& v) const;
-  uint32_t get_norm_idx(const Loop& l) const;
-  uint32_t get_skin_idx(const Vertex& v) const;
-  uint32_t get_color_idx(const Loop& l, uint32_t cidx) const;
-  uint32_t get_uv_idx(const Loop& l, uint32_t uidx) const;
+  /* Skins are hashed on their valid (leading) binds only */
+  struct SkinHash {
+    size_t operator()(const std::array<Mesh::SkinBind, MaxSkinEntries>& skin) const noexcept {
+      size_t h = 0;
+      for (const Mesh::SkinBind& bind : skin) {
+        if (!bind.valid())
+          break;
+        hecl::hash_combine_impl(h, size_t(bind.vg_idx));
+        hecl::hash_combine_impl(h, std::hash<float>()(bind.weight));
+      }
+      return h;
+    }
+  };
+
+  AttrPool<Vector3f> b_pos;
+  AttrPool<Vector3f> b_norm;
+  AttrPool<std::array<Mesh::SkinBind, MaxSkinEntries>, SkinHash> b_skin;
+  AttrPool<Vector3f> b_color;
+  AttrPool<Vector2f> b_uv;
+  AttrPool<Vector2f> b_luv;
+
+  uint32_t get_pos_idx(uint32_t vert) const;
+  uint32_t get_norm_idx(uint32_t loop) const;
+  uint32_t get_skin_idx(uint32_t vert) const;
+  uint32_t get_color_idx(uint32_t loop, uint32_t cidx) const;
+  uint32_t get_uv_idx(uint32_t loop, uint32_t uidx) const;
+  bool loop_uses_luv(uint32_t loop) const;
   void sort_faces_by_skin_group(std::vector<uint32_t>& faces) const;
   std::pair<uint32_t, uint32_t> strip_next_loop(uint32_t prev_loop, uint32_t out_count) const;
 
-  bool loops_contiguous(const Loop& la, const Loop& lb) const;
+  bool loops_contiguous(uint32_t la, uint32_t lb) const;
   bool splitable_edge(const Edge& e) const;
-  Mesh::Surface generate_surface(std::vector<uint32_t>& island_faces, uint32_t mat_idx) const;
+  Mesh::Surface::Vert make_vert(uint32_t loop) const;
+  void emit_triangles(Mesh::Surface& surf, const std::vector<uint32_t>& island_faces) const;
+  Mesh::Surface generate_surface(std::vector<uint32_t>& island_faces, uint32_t mat_idx, HMDLTopology topology) const;
+  void generate_material_surfaces(std::vector<uint32_t> mat_faces_rem, uint32_t mat_idx, int max_skin_banks,
+                                  HMDLTopology topology, std::vector<Mesh::Surface>& out) const;
+
+  /* Meshes smaller than this generate their surfaces on the calling thread */
+  static constexpr size_t ParallelFaceThreshold = 8192;
+
+  /* Meshes with fewer verts dedup their attributes after reading, on the calling thread */
+  static constexpr size_t PipelineVertThreshold = 8192;
+
+  /* Helper thread filling the attribute pools as their columns arrive */
+  class DedupPipeline;
+  enum class DedupStage : uint32_t { Verts, Normals, Colors, UVs };
+
+  template <typename T>
+  static void read_column(Connection& conn, std::vector<T>& out, uint32_t count, size_t packed_size = sizeof(T));
+  void read_verts(Connection& conn);
+  void read_faces(Connection& conn);
+  void read_loops(Connection& conn, DedupPipeline* pipeline);
+  void read_edges(Connection& conn);
+  void dedup(DedupStage stage);
 
 public:
   explicit MeshOptimizer(Connection& conn, const std::vector<Material>& materials, bool use_luvs);
   void optimize(Mesh& mesh, int max_skin_banks) const;
 };
 
-}
\ No newline at end of file
+}
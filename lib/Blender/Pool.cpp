@@ -0,0 +1,481 @@
+#include "hecl/Blender/Pool.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include "hecl/Blender/Connection.hpp"
+#include "hecl/hecl.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace hecl::blender {
+static logvisor::Module Log("hecl::blender::Pool");
+
+extern "C" uint8_t HECL_BLENDERSHELL[];
+extern "C" size_t HECL_BLENDERSHELL_SZ;
+
+extern "C" uint8_t HECL_ADDON[];
+extern "C" size_t HECL_ADDON_SZ;
+
+std::atomic_bool PoolDaemon::StopRequested(false);
+
+namespace {
+enum class PoolOp : uint32_t { Acquire = 1, Release = 2 };
+enum class PoolStatus : uint32_t { Ok, Busy, BuildMismatch };
+
+struct PoolRequest {
+  PoolOp op;
+  uint32_t shell;
+  uint64_t buildId;
+  uint64_t blendHash;
+  PoolShellState state;
+};
+
+struct PoolReply {
+  PoolStatus status;
+  uint32_t shell;
+  int32_t pid;
+  uint32_t fdCount;
+  PoolShellState state;
+};
+
+/* Shells only speak the protocol of the blendershell and addon they were started with */
+uint64_t BuildId() {
+  static const uint64_t Id = [] {
+    XXH64_state_t st;
+    XXH64_reset(&st, 0);
+    XXH64_update(&st, HECL_BLENDERSHELL, HECL_BLENDERSHELL_SZ);
+    XXH64_update(&st, HECL_ADDON, HECL_ADDON_SZ);
+    return uint64_t(XXH64_digest(&st));
+  }();
+  return Id;
+}
+
+#ifndef _WIN32
+bool SendAll(int sock, const void* buf, std::size_t len) {
+  const auto* cBuf = static_cast<const uint8_t*>(buf);
+  while (len) {
+    const ssize_t ret = send(sock, cBuf, len, 0);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    cBuf += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+bool RecvAll(int sock, void* buf, std::size_t len) {
+  auto* cBuf = static_cast<uint8_t*>(buf);
+  while (len) {
+    const ssize_t ret = recv(sock, cBuf, len, 0);
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret <= 0)
+      return false;
+    cBuf += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+bool SendReply(int sock, const PoolReply& reply, const int* fds) {
+  iovec iov{const_cast<PoolReply*>(&reply), sizeof(reply)};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int) * 3)];
+  if (reply.fdCount) {
+    msg.msg_control = ctrl;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * reply.fdCount);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * reply.fdCount);
+    std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * reply.fdCount);
+  }
+  ssize_t ret;
+  do {
+    ret = sendmsg(sock, &msg, 0);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0)
+    return false;
+  /* Descriptors travel with the first byte; any remainder is plain data */
+  return SendAll(sock, reinterpret_cast<const uint8_t*>(&reply) + ret, sizeof(reply) - ret);
+}
+
+bool RecvReply(int sock, PoolReply& reply, int (&fds)[3]) {
+  iovec iov{&reply, sizeof(reply)};
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  alignas(cmsghdr) char ctrl[CMSG_SPACE(sizeof(int) * 3)];
+  msg.msg_control = ctrl;
+  msg.msg_controllen = sizeof(ctrl);
+#ifdef MSG_CMSG_CLOEXEC
+  const int flags = MSG_CMSG_CLOEXEC;
+#else
+  const int flags = 0;
+#endif
+  ssize_t ret;
+  do {
+    ret = recvmsg(sock, &msg, flags);
+  } while (ret < 0 && errno == EINTR);
+  if (ret <= 0)
+    return false;
+
+  uint32_t fdCount = 0;
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+      continue;
+    const std::size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (std::size_t i = 0; i < count; ++i) {
+      int fd;
+      std::memcpy(&fd, CMSG_DATA(cmsg) + sizeof(int) * i, sizeof(int));
+      if (fdCount < 3)
+        fds[fdCount++] = fd;
+      else
+        close(fd);
+    }
+  }
+
+  if (!RecvAll(sock, reinterpret_cast<uint8_t*>(&reply) + ret, sizeof(reply) - ret) || fdCount != reply.fdCount) {
+    for (uint32_t i = 0; i < fdCount; ++i)
+      close(fds[i]);
+    return false;
+  }
+  return true;
+}
+
+bool MakeSocketAddr(const SystemString& path, sockaddr_un& addr) {
+  addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    return false;
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+std::size_t ShellRss(pid_t pid) {
+#if __linux__
+  auto fp = hecl::FopenUnique(fmt::format(FMT_STRING("/proc/{}/statm"), pid).c_str(), "r");
+  if (!fp)
+    return 0;
+  unsigned long long size, resident;
+  if (std::fscanf(fp.get(), "%llu %llu", &size, &resident) != 2)
+    return 0;
+  return std::size_t(resident) * std::size_t(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+#endif
+} // namespace
+
+SystemString GetPoolSocketPath() {
+#ifndef _WIN32
+  return SystemString(GetTmpDir()) + fmt::format(FMT_STRING("/hecl_blenderpool_{}.sock"), getuid());
+#else
+  return {};
+#endif
+}
+
+PoolClient::~PoolClient() {
+#ifndef _WIN32
+  close(m_sock);
+#endif
+}
+
+std::unique_ptr<PoolClient> PoolClient::Connect() {
+#ifndef _WIN32
+  sockaddr_un addr;
+  if (!MakeSocketAddr(GetPoolSocketPath(), addr))
+    return {};
+  const int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock < 0)
+    return {};
+  fcntl(sock, F_SETFD, FD_CLOEXEC);
+  if (connect(sock, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr))) {
+    close(sock);
+    return {};
+  }
+  return std::unique_ptr<PoolClient>(new PoolClient(sock));
+#else
+  return {};
+#endif
+}
+
+PoolLease PoolClient::acquire(uint64_t blendHash, uint32_t returnShell, const PoolShellState& returnState) {
+  PoolLease lease;
+#ifndef _WIN32
+  const PoolRequest req{PoolOp::Acquire, returnShell, BuildId(), blendHash, returnState};
+  if (!SendAll(m_sock, &req, sizeof(req)))
+    return lease;
+  PoolReply reply;
+  int fds[3] = {-1, -1, -1};
+  if (!RecvReply(m_sock, reply, fds))
+    return lease;
+
+  switch (reply.status) {
+  case PoolStatus::Ok:
+    break;
+  case PoolStatus::Busy:
+    if (hecl::VerbosityLevel >= 1)
+      Log.report(logvisor::Info, FMT_STRING("all pooled blender shells are busy"));
+    return lease;
+  case PoolStatus::BuildMismatch:
+    Log.report(logvisor::Warning, FMT_STRING("blender pool daemon was started by a different hecl build; "
+                                             "restart `hecl blenderpool` to use it"));
+    return lease;
+  }
+
+  if (reply.fdCount < 2) {
+    for (int fd : fds)
+      if (fd >= 0)
+        close(fd);
+    return lease;
+  }
+  lease.shell = reply.shell;
+  lease.pid = reply.pid;
+  lease.readFd = fds[0];
+  lease.writeFd = fds[1];
+  lease.bulkFd = fds[2];
+  lease.state = reply.state;
+#endif
+  return lease;
+}
+
+void PoolClient::release(uint32_t shell, const PoolShellState& state) {
+#ifndef _WIN32
+  const PoolRequest req{PoolOp::Release, shell, BuildId(), 0, state};
+  SendAll(m_sock, &req, sizeof(req));
+#endif
+}
+
+PoolDaemon::PoolDaemon(std::size_t shellCount, std::size_t maxRss)
+: m_shells(shellCount), m_sockPath(GetPoolSocketPath()), m_maxRss(maxRss) {}
+
+PoolDaemon::~PoolDaemon() {
+#ifndef _WIN32
+  for (int client : m_clients)
+    close(client);
+  if (m_listen >= 0) {
+    close(m_listen);
+    unlink(m_sockPath.c_str());
+  }
+#endif
+}
+
+void PoolDaemon::_spawnShell(Shell& shell) {
+  shell.conn = std::make_unique<Connection>(hecl::VerbosityLevel);
+  shell.client = -1;
+  shell.state = {};
+}
+
+void PoolDaemon::_killShell(Shell& shell) {
+#ifndef _WIN32
+  /* The shell may be mid-stream; it can't be trusted to process QUIT */
+  kill(shell.conn->m_blenderProc, SIGKILL);
+  waitpid(shell.conn->m_blenderProc, nullptr, 0);
+  shell.conn->m_blenderQuit = true;
+#endif
+  shell.conn.reset();
+}
+
+void PoolDaemon::_returnShell(uint32_t idx, const PoolShellState& state) {
+  Shell& shell = m_shells[idx];
+  shell.client = -1;
+  shell.state = state;
+  shell.lastUse = ++m_useCounter;
+#ifndef _WIN32
+  if (m_maxRss) {
+    const std::size_t rss = ShellRss(shell.conn->m_blenderProc);
+    if (rss > m_maxRss) {
+      Log.report(logvisor::Info, FMT_STRING("restarting blender shell {} ({} MiB resident)"), idx, rss >> 20);
+      shell.conn->quitBlender();
+      _spawnShell(shell);
+    }
+  }
+#endif
+}
+
+uint32_t PoolDaemon::_selectShell(uint64_t blendHash, uint32_t returned) const {
+  uint32_t lru = UINT32_MAX;
+  for (uint32_t i = 0; i < m_shells.size(); ++i) {
+    const Shell& shell = m_shells[i];
+    if (shell.client >= 0)
+      continue;
+    if (blendHash && shell.state.blendHash == blendHash)
+      return i;
+    if (lru == UINT32_MAX || shell.lastUse < m_shells[lru].lastUse)
+      lru = i;
+  }
+  /* No affinity; let the client keep the shell it came with */
+  if (returned < m_shells.size() && m_shells[returned].client < 0)
+    return returned;
+  return lru;
+}
+
+bool PoolDaemon::_serviceClient(int client) {
+#ifndef _WIN32
+  PoolRequest req;
+  if (!RecvAll(client, &req, sizeof(req)))
+    return false;
+
+  if (req.shell != UINT32_MAX) {
+    if (req.shell >= m_shells.size() || m_shells[req.shell].client != client) {
+      Log.report(logvisor::Warning, FMT_STRING("client returned blender shell {} it does not hold"), req.shell);
+      return false;
+    }
+    _returnShell(req.shell, req.state);
+  }
+
+  if (req.op == PoolOp::Release)
+    return true;
+  if (req.op != PoolOp::Acquire)
+    return false;
+
+  PoolReply reply{};
+  reply.shell = UINT32_MAX;
+  if (req.buildId != BuildId()) {
+    reply.status = PoolStatus::BuildMismatch;
+    return SendReply(client, reply, nullptr);
+  }
+
+  const uint32_t idx = _selectShell(req.blendHash, req.shell);
+  if (idx == UINT32_MAX) {
+    reply.status = PoolStatus::Busy;
+    return SendReply(client, reply, nullptr);
+  }
+
+  Shell& shell = m_shells[idx];
+  if (waitpid(shell.conn->m_blenderProc, nullptr, WNOHANG) == shell.conn->m_blenderProc) {
+    Log.report(logvisor::Warning, FMT_STRING("blender shell {} exited while idle; restarting it"), idx);
+    shell.conn->m_blenderQuit = true;
+    _spawnShell(shell);
+  }
+  shell.client = client;
+  shell.lastUse = ++m_useCounter;
+
+  reply.status = PoolStatus::Ok;
+  reply.shell = idx;
+  reply.pid = shell.conn->m_blenderProc;
+  reply.state = shell.state;
+  const int fds[3] = {shell.conn->m_readpipe[0], shell.conn->m_writepipe[1], shell.conn->m_bulkFd};
+  reply.fdCount = fds[2] >= 0 ? 3 : 2;
+  return SendReply(client, reply, fds);
+#else
+  return false;
+#endif
+}
+
+void PoolDaemon::_dropClient(int client) {
+#ifndef _WIN32
+  for (Shell& shell : m_shells) {
+    if (shell.client == client) {
+      Log.report(logvisor::Warning, FMT_STRING("client disconnected while holding a blender shell; restarting it"));
+      _killShell(shell);
+      _spawnShell(shell);
+    }
+  }
+  close(client);
+  m_clients.erase(std::find(m_clients.begin(), m_clients.end(), client));
+#endif
+}
+
+int PoolDaemon::run() {
+#ifndef _WIN32
+  signal(SIGPIPE, SIG_IGN);
+
+  sockaddr_un addr;
+  if (!MakeSocketAddr(m_sockPath, addr)) {
+    Log.report(logvisor::Error, FMT_STRING("socket path '{}' is too long"), m_sockPath);
+    return 1;
+  }
+
+  /* A socket that accepts connections belongs to a live daemon; anything else is stale */
+  if (PoolClient::Connect()) {
+    Log.report(logvisor::Error, FMT_STRING("a blender pool is already listening on '{}'"), m_sockPath);
+    return 1;
+  }
+  unlink(m_sockPath.c_str());
+
+  m_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (m_listen < 0) {
+    Log.report(logvisor::Error, FMT_STRING("unable to create socket: {}"), strerror(errno));
+    return 1;
+  }
+  fcntl(m_listen, F_SETFD, FD_CLOEXEC);
+  if (bind(m_listen, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) || listen(m_listen, 16)) {
+    Log.report(logvisor::Error, FMT_STRING("unable to listen on '{}': {}"), m_sockPath, strerror(errno));
+    close(m_listen);
+    m_listen = -1;
+    return 1;
+  }
+  /* Leases hand out live processes; keep them to this user */
+  chmod(m_sockPath.c_str(), 0600);
+
+  for (Shell& shell : m_shells)
+    _spawnShell(shell);
+  Log.report(logvisor::Info, FMT_STRING("serving {} blender shells on '{}'"), m_shells.size(), m_sockPath);
+
+  std::vector<pollfd> pfds;
+  while (!StopRequested) {
+    pfds.clear();
+    pfds.push_back({m_listen, POLLIN, 0});
+    for (int client : m_clients)
+      pfds.push_back({client, POLLIN, 0});
+
+    if (poll(pfds.data(), nfds_t(pfds.size()), 500) < 0) {
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Fatal, FMT_STRING("poll failed: {}"), strerror(errno));
+    }
+
+    if (pfds[0].revents & POLLIN) {
+      const int client = accept(m_listen, nullptr, nullptr);
+      if (client >= 0) {
+        fcntl(client, F_SETFD, FD_CLOEXEC);
+        m_clients.push_back(client);
+      }
+    }
+
+    for (std::size_t i = 1; i < pfds.size(); ++i)
+      if (pfds[i].revents & (POLLIN | POLLHUP | POLLERR))
+        if (!_serviceClient(pfds[i].fd))
+          _dropClient(pfds[i].fd);
+  }
+
+  for (Shell& shell : m_shells) {
+    if (!shell.conn)
+      continue;
+    if (shell.client >= 0) {
+      _killShell(shell);
+    } else {
+      shell.conn->quitBlender();
+      shell.conn.reset();
+    }
+  }
+  return 0;
+#else
+  Log.report(logvisor::Error, FMT_STRING("the blender pool is not supported on this platform"));
+  return 1;
+#endif
+}
+
+} // namespace hecl::blender
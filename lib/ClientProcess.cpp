@@ -1,6 +1,8 @@
 #include "hecl/ClientProcess.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <new>
 
 #include "hecl/Blender/Connection.hpp"
 #include "hecl/Database.hpp"
@@ -62,6 +64,164 @@ static int GetCPUCount() {
   return ret;
 }
 
+namespace {
+/* Fixed-size block pool backing transaction allocations (object and shared_ptr control block).
+ * Threads keep a small local cache per size class and exchange blocks with the shared
+ * free lists in batches, so steady-state allocation takes no lock at all. */
+class TransactionPool {
+  static constexpr size_t BlockGranularity = 64;
+  static constexpr size_t ClassCount = 8;
+  static constexpr size_t BatchSize = 32;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+  struct SharedList {
+    std::mutex lock;
+    FreeBlock* head = nullptr;
+  };
+  SharedList m_shared[ClassCount];
+
+  struct LocalCache {
+    FreeBlock* head[ClassCount] = {};
+    size_t count[ClassCount] = {};
+    ~LocalCache() {
+      for (size_t i = 0; i < ClassCount; ++i)
+        if (head[i])
+          Instance().releaseBatch(i, head[i]);
+    }
+  };
+  static thread_local LocalCache t_cache;
+
+  static constexpr size_t ClassIndex(size_t size) { return (size + BlockGranularity - 1) / BlockGranularity - 1; }
+  static constexpr size_t ClassSize(size_t cls) { return (cls + 1) * BlockGranularity; }
+
+  FreeBlock* acquireBatch(size_t cls) {
+    {
+      std::lock_guard lk{m_shared[cls].lock};
+      if (FreeBlock* head = m_shared[cls].head) {
+        FreeBlock* tail = head;
+        for (size_t i = 1; i < BatchSize && tail->next; ++i)
+          tail = tail->next;
+        m_shared[cls].head = tail->next;
+        tail->next = nullptr;
+        return head;
+      }
+    }
+
+    /* Carve a new slab; slabs live for the duration of the process */
+    const size_t blockSize = ClassSize(cls);
+    auto* slab = static_cast<uint8_t*>(::operator new(blockSize * BatchSize, std::align_val_t(BlockGranularity)));
+    FreeBlock* head = nullptr;
+    for (size_t i = BatchSize; i-- > 0;) {
+      auto* block = reinterpret_cast<FreeBlock*>(slab + blockSize * i);
+      block->next = head;
+      head = block;
+    }
+    return head;
+  }
+
+  void releaseBatch(size_t cls, FreeBlock* head) {
+    FreeBlock* tail = head;
+    while (tail->next)
+      tail = tail->next;
+    std::lock_guard lk{m_shared[cls].lock};
+    tail->next = m_shared[cls].head;
+    m_shared[cls].head = head;
+  }
+
+public:
+  static TransactionPool& Instance() {
+    static TransactionPool pool;
+    return pool;
+  }
+
+  void* allocate(size_t size) {
+    const size_t cls = ClassIndex(size);
+    if (cls >= ClassCount)
+      return ::operator new(size);
+
+    LocalCache& cache = t_cache;
+    if (!cache.head[cls]) {
+      cache.head[cls] = acquireBatch(cls);
+      cache.count[cls] = 0;
+      for (FreeBlock* block = cache.head[cls]; block; block = block->next)
+        ++cache.count[cls];
+    }
+    FreeBlock* block = cache.head[cls];
+    cache.head[cls] = block->next;
+    --cache.count[cls];
+    return block;
+  }
+
+  void deallocate(void* ptr, size_t size) {
+    const size_t cls = ClassIndex(size);
+    if (cls >= ClassCount) {
+      ::operator delete(ptr);
+      return;
+    }
+
+    LocalCache& cache = t_cache;
+    auto* block = static_cast<FreeBlock*>(ptr);
+    block->next = cache.head[cls];
+    cache.head[cls] = block;
+    if (++cache.count[cls] >= BatchSize * 2) {
+      /* Hand a batch back so blocks freed away from their allocating thread get reused */
+      FreeBlock* tail = cache.head[cls];
+      for (size_t i = 1; i < BatchSize; ++i)
+        tail = tail->next;
+      FreeBlock* batch = cache.head[cls];
+      cache.head[cls] = tail->next;
+      tail->next = nullptr;
+      cache.count[cls] -= BatchSize;
+      releaseBatch(cls, batch);
+    }
+  }
+};
+thread_local TransactionPool::LocalCache TransactionPool::t_cache;
+
+template <typename T>
+struct PoolAllocator {
+  using value_type = T;
+  PoolAllocator() noexcept = default;
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {}
+  T* allocate(size_t n) { return static_cast<T*>(TransactionPool::Instance().allocate(n * sizeof(T))); }
+  void deallocate(T* p, size_t n) noexcept { TransactionPool::Instance().deallocate(p, n * sizeof(T)); }
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const noexcept {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+template <typename T, typename... Args>
+std::shared_ptr<T> MakePooledTransaction(Args&&... args) {
+  return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+/* Expected cook time in milliseconds; recorded durations win over the DataSpec's estimate */
+uint32_t EstimateCookDuration(const ProjectPath& path, Database::IDataSpec* spec) {
+  uint32_t ms;
+  if (path.getProject().getCookDatabase().lookupCookDuration(path, ms))
+    return ms;
+  switch (spec->getCookCost(path)) {
+  case Database::CookCost::None:
+    return 0;
+  case Database::CookCost::Light:
+    return 100;
+  case Database::CookCost::Medium:
+  default:
+    return 1000;
+  case Database::CookCost::Heavy:
+    return 10000;
+  }
+}
+} // namespace
+
 void ClientProcess::BufferTransaction::run(blender::Token& btok) {
   athena::io::FileReader r(m_path.getAbsolutePath(), 32 * 1024, false);
   if (r.hasError()) {
@@ -77,9 +237,9 @@ void ClientProcess::BufferTransaction::run(blender::Token& btok) {
 void ClientProcess::CookTransaction::run(blender::Token& btok) {
   m_dataSpec->setThreadProject();
   m_returnResult = m_parent.syncCook(m_path, m_dataSpec, btok, m_force, m_fast);
-  std::unique_lock lk{m_parent.m_mutex};
-  ++m_parent.m_completedCooks;
-  m_parent.m_progPrinter->setMainFactor(m_parent.m_completedCooks / float(m_parent.m_addedCooks));
+  const int completedCooks = ++m_parent.m_completedCooks;
+  if (m_parent.m_progPrinter)
+    m_parent.m_progPrinter->setMainFactor(completedCooks / float(m_parent.m_addedCooks));
   m_complete = true;
 }
 
@@ -98,28 +258,33 @@ void ClientProcess::Worker::proc() {
   std::string thrName = fmt::format(FMT_STRING("HECL Worker {}"), m_idx);
   logvisor::RegisterThreadName(thrName.c_str());
 
-  std::unique_lock lk{m_proc.m_mutex};
+  {
+    std::unique_lock lk{m_proc.m_mutex};
+    m_didInit = true;
+    m_proc.m_initCv.notify_one();
+  }
+
+  std::shared_ptr<Transaction> trans;
   while (m_proc.m_running) {
-    if (!m_didInit) {
-      m_proc.m_initCv.notify_one();
-      m_didInit = true;
-    }
-    while (m_proc.m_running && m_proc.m_pendingQueue.size()) {
-      std::shared_ptr<Transaction> trans = std::move(m_proc.m_pendingQueue.front());
-      ++m_proc.m_inProgress;
-      m_proc.m_pendingQueue.pop_front();
-      lk.unlock();
+    if (m_proc.acquireTransaction(*this, trans)) {
       trans->run(m_blendTok);
-      lk.lock();
-      m_proc.m_completedQueue.push_back(std::move(trans));
-      --m_proc.m_inProgress;
+      {
+        std::unique_lock lk{m_proc.m_completedMutex};
+        m_proc.m_completedQueue.push_back(std::move(trans));
+      }
+      if (--m_proc.m_inProgress == 0 && m_proc.m_pendingCount == 0) {
+        std::unique_lock lk{m_proc.m_mutex};
+        m_proc.m_waitCv.notify_all();
+      }
+      continue;
     }
-    m_proc.m_waitCv.notify_one();
-    if (!m_proc.m_running)
-      break;
-    m_proc.m_cv.wait(lk);
+
+    std::unique_lock lk{m_proc.m_mutex};
+    ++m_proc.m_sleeping;
+    while (m_proc.m_running && m_proc.m_pendingCount == 0)
+      m_proc.m_cv.wait(lk);
+    --m_proc.m_sleeping;
   }
-  lk.unlock();
   m_blendTok.shutdown();
 }
 
@@ -132,39 +297,161 @@ ClientProcess::ClientProcess(const MultiProgressPrinter* progPrinter) : m_progPr
   m_workers.reserve(cpuCount);
   for (int i = 0; i < cpuCount; ++i) {
     std::unique_lock lk{m_mutex};
-    m_workers.emplace_back(*this, m_workers.size());
-    m_initCv.wait(lk);
+    Worker& worker = *m_workers.emplace_back(std::make_unique<Worker>(*this, i));
+    m_initCv.wait(lk, [&]() { return worker.m_didInit; });
   }
 }
 
+ClientProcess::Worker& ClientProcess::selectWorker() {
+  /* Keep work spawned by a transaction local to its worker */
+  if (Worker* w = ThreadWorker.get(); w && &w->m_proc == this)
+    return *w;
+  return *m_workers[m_nextWorker++ % m_workers.size()];
+}
+
+void ClientProcess::enqueue(Worker& worker, std::shared_ptr<Transaction>&& trans) {
+  /* Count first so the pending count never undercounts queued transactions */
+  ++m_pendingCount;
+  std::unique_lock lk{worker.m_queueMutex};
+  worker.m_queue.push_back(std::move(trans));
+}
+
+void ClientProcess::enqueueByCost(uint32_t estimateMs, std::shared_ptr<Transaction>&& trans) {
+  ++m_pendingCount;
+  std::unique_lock lk{m_costMutex};
+  m_costQueue.push_back({estimateMs, m_costSequence++, std::move(trans)});
+  std::push_heap(m_costQueue.begin(), m_costQueue.end());
+  ++m_costQueueSize;
+}
+
+void ClientProcess::wakeWorkers(int count) {
+  if (m_sleeping == 0)
+    return;
+  std::unique_lock lk{m_mutex};
+  if (count > 1)
+    m_cv.notify_all();
+  else
+    m_cv.notify_one();
+}
+
+bool ClientProcess::acquireTransaction(Worker& worker, std::shared_ptr<Transaction>& out) {
+  if (m_pendingCount == 0)
+    return false;
+
+  auto take = [&](Worker& from, bool front) {
+    std::unique_lock lk{from.m_queueMutex};
+    if (from.m_queue.empty())
+      return false;
+    if (front) {
+      out = std::move(from.m_queue.front());
+      from.m_queue.pop_front();
+    } else {
+      out = std::move(from.m_queue.back());
+      from.m_queue.pop_back();
+    }
+    /* In-progress is raised before pending drops so isBusy() never sees a gap */
+    ++m_inProgress;
+    --m_pendingCount;
+    return true;
+  };
+
+  if (take(worker, true))
+    return true;
+
+  const size_t workerCount = m_workers.size();
+  for (size_t i = 1; i < workerCount; ++i)
+    if (take(*m_workers[(worker.m_idx + i) % workerCount], false))
+      return true;
+
+  /* Cooks held by cost go last; deques then only hold discovery (lambda/buffer) work,
+   * which must keep feeding the heap for longest-first ordering to span the whole cook */
+  if (m_costQueueSize) {
+    std::unique_lock lk{m_costMutex};
+    if (!m_costQueue.empty()) {
+      std::pop_heap(m_costQueue.begin(), m_costQueue.end());
+      out = std::move(m_costQueue.back().m_trans);
+      m_costQueue.pop_back();
+      --m_costQueueSize;
+      ++m_inProgress;
+      --m_pendingCount;
+      return true;
+    }
+  }
+
+  return false;
+}
+
 std::shared_ptr<const ClientProcess::BufferTransaction> ClientProcess::addBufferTransaction(const ProjectPath& path,
                                                                                             void* target, size_t maxLen,
                                                                                             size_t offset) {
-  std::unique_lock lk{m_mutex};
-  auto ret = std::make_shared<BufferTransaction>(*this, path, target, maxLen, offset);
-  m_pendingQueue.emplace_back(ret);
-  m_cv.notify_one();
+  auto ret = MakePooledTransaction<BufferTransaction>(*this, path, target, maxLen, offset);
+  enqueue(selectWorker(), ret);
+  wakeWorkers(1);
   return ret;
 }
 
 std::shared_ptr<const ClientProcess::CookTransaction> ClientProcess::addCookTransaction(const hecl::ProjectPath& path,
                                                                                         bool force, bool fast,
                                                                                         Database::IDataSpec* spec) {
-  std::unique_lock lk{m_mutex};
-  auto ret = std::make_shared<CookTransaction>(*this, path, force, fast, spec);
-  m_pendingQueue.emplace_back(ret);
-  m_cv.notify_one();
-  ++m_addedCooks;
-  m_progPrinter->setMainFactor(m_completedCooks / float(m_addedCooks));
+  auto ret = MakePooledTransaction<CookTransaction>(*this, path, force, fast, spec);
+  const int addedCooks = ++m_addedCooks;
+  if (m_progPrinter)
+    m_progPrinter->setMainFactor(m_completedCooks / float(addedCooks));
+  if (m_longestFirst)
+    enqueueByCost(EstimateCookDuration(path, spec), ret);
+  else
+    enqueue(selectWorker(), ret);
+  wakeWorkers(1);
+  return ret;
+}
+
+std::vector<std::shared_ptr<const ClientProcess::CookTransaction>>
+ClientProcess::addCookTransactions(const std::vector<hecl::ProjectPath>& paths, bool force, bool fast,
+                                   Database::IDataSpec* spec) {
+  std::vector<std::shared_ptr<const CookTransaction>> ret;
+  if (paths.empty())
+    return ret;
+  ret.reserve(paths.size());
+
+  const int addedCooks = m_addedCooks += int(paths.size());
+  if (m_progPrinter)
+    m_progPrinter->setMainFactor(m_completedCooks / float(addedCooks));
+
+  if (m_longestFirst) {
+    for (const hecl::ProjectPath& path : paths) {
+      auto trans = MakePooledTransaction<CookTransaction>(*this, path, force, fast, spec);
+      ret.push_back(trans);
+      enqueueByCost(EstimateCookDuration(path, spec), std::move(trans));
+    }
+    wakeWorkers(int(paths.size()));
+    return ret;
+  }
+
+  /* Hand each worker a contiguous share under a single lock acquisition */
+  const size_t workerCount = m_workers.size();
+  const size_t share = (paths.size() + workerCount - 1) / workerCount;
+  const size_t firstWorker = m_nextWorker++;
+  for (size_t w = 0, p = 0; w < workerCount && p < paths.size(); ++w) {
+    Worker& worker = *m_workers[(firstWorker + w) % workerCount];
+    const size_t end = std::min(p + share, paths.size());
+    m_pendingCount += int(end - p);
+    std::unique_lock lk{worker.m_queueMutex};
+    for (; p < end; ++p) {
+      auto trans = MakePooledTransaction<CookTransaction>(*this, paths[p], force, fast, spec);
+      ret.push_back(trans);
+      worker.m_queue.push_back(std::move(trans));
+    }
+  }
+
+  wakeWorkers(int(paths.size()));
   return ret;
 }
 
 std::shared_ptr<const ClientProcess::LambdaTransaction>
 ClientProcess::addLambdaTransaction(std::function<void(blender::Token&)>&& func) {
-  std::unique_lock lk{m_mutex};
-  auto ret = std::make_shared<LambdaTransaction>(*this, std::move(func));
-  m_pendingQueue.emplace_back(ret);
-  m_cv.notify_one();
+  auto ret = MakePooledTransaction<LambdaTransaction>(*this, std::move(func));
+  enqueue(selectWorker(), ret);
+  wakeWorkers(1);
   return ret;
 }
 
@@ -177,7 +464,10 @@ bool ClientProcess::syncCook(const hecl::ProjectPath& path, Database::IDataSpec*
       if (fast)
         cooked = cooked.getWithExtension(_SYS_STR(".fast"));
       cooked.makeDirChain(false);
-      if (force || cooked.getPathType() == ProjectPath::Type::None || path.getModtime() > cooked.getModtime()) {
+      Database::CookDatabase& cookDb = path.getProject().getCookDatabase();
+      Hash contentHash;
+      const uint32_t cookVersion = spec->getCookVersion();
+      if (!cookDb.isUpToDate(path, cooked, cookVersion, contentHash) || force) {
         if (m_progPrinter) {
           hecl::SystemString str;
           if (path.getAuxInfo().empty())
@@ -192,7 +482,15 @@ bool ClientProcess::syncCook(const hecl::ProjectPath& path, Database::IDataSpec*
           else
             LogModule.report(logvisor::Info, FMT_STRING(_SYS_STR("Cooking {}|{}")), path.getRelativePath(), path.getAuxInfo());
         }
+        const auto cookStart = std::chrono::steady_clock::now();
         spec->doCook(path, cooked, false, btok, [](const SystemChar*) {});
+        cooked.invalidateStat();
+        const auto cookMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cookStart);
+        std::vector<ProjectPath> deps;
+        spec->getCookDependencies(path, deps);
+        cookDb.recordCook(path, cooked, cookVersion, contentHash, deps);
+        cookDb.recordCookDuration(path, uint32_t(cookMs.count()));
         if (m_progPrinter) {
           hecl::SystemString str;
           if (path.getAuxInfo().empty())
@@ -210,7 +508,7 @@ bool ClientProcess::syncCook(const hecl::ProjectPath& path, Database::IDataSpec*
 }
 
 void ClientProcess::swapCompletedQueue(std::list<std::shared_ptr<Transaction>>& queue) {
-  std::unique_lock lk{m_mutex};
+  std::unique_lock lk{m_completedMutex};
   queue.swap(m_completedQueue);
 }
 
@@ -224,13 +522,23 @@ void ClientProcess::shutdown() {
   if (!m_running)
     return;
   std::unique_lock lk{m_mutex};
-  m_pendingQueue.clear();
   m_running = false;
+  {
+    std::unique_lock qlk{m_costMutex};
+    m_pendingCount -= int(m_costQueue.size());
+    m_costQueue.clear();
+    m_costQueueSize = 0;
+  }
+  for (auto& worker : m_workers) {
+    std::unique_lock qlk{worker->m_queueMutex};
+    m_pendingCount -= int(worker->m_queue.size());
+    worker->m_queue.clear();
+  }
   m_cv.notify_all();
   lk.unlock();
-  for (Worker& worker : m_workers)
-    if (worker.m_thr.joinable())
-      worker.m_thr.join();
+  for (auto& worker : m_workers)
+    if (worker->m_thr.joinable())
+      worker->m_thr.join();
 }
 
 } // namespace hecl
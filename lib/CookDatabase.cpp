@@ -0,0 +1,413 @@
+#include "hecl/CookDatabase.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "hecl/Database.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+namespace hecl::Database {
+static logvisor::Module Log("hecl::Database::CookDatabase");
+
+constexpr hecl::FourCC CKDBfcc("CKDB");
+constexpr uint32_t COOKDB_VERSION = 4;
+
+namespace {
+class DBWriter {
+  std::vector<uint8_t> m_data;
+
+public:
+  void writeBytes(const void* data, size_t len) {
+    const auto* ptr = static_cast<const uint8_t*>(data);
+    m_data.insert(m_data.end(), ptr, ptr + len);
+  }
+  void writeU32(uint32_t val) {
+    val = SLittle(val);
+    writeBytes(&val, 4);
+  }
+  void writeU64(uint64_t val) {
+    val = SLittle(val);
+    writeBytes(&val, 8);
+  }
+  void writeString(std::string_view str) {
+    writeU32(uint32_t(str.size()));
+    writeBytes(str.data(), str.size());
+  }
+  const std::vector<uint8_t>& data() const { return m_data; }
+};
+
+class DBReader {
+  const uint8_t* m_cur;
+  const uint8_t* m_end;
+  bool m_error = false;
+
+public:
+  DBReader(const std::vector<uint8_t>& data) : m_cur(data.data()), m_end(data.data() + data.size()) {}
+  bool readBytes(void* out, size_t len) {
+    if (m_error || size_t(m_end - m_cur) < len) {
+      m_error = true;
+      return false;
+    }
+    std::memcpy(out, m_cur, len);
+    m_cur += len;
+    return true;
+  }
+  uint32_t readU32() {
+    uint32_t val = 0;
+    readBytes(&val, 4);
+    return SLittle(val);
+  }
+  uint64_t readU64() {
+    uint64_t val = 0;
+    readBytes(&val, 8);
+    return SLittle(val);
+  }
+  std::string readString() {
+    const uint32_t len = readU32();
+    if (m_error || size_t(m_end - m_cur) < len) {
+      m_error = true;
+      return {};
+    }
+    std::string ret(reinterpret_cast<const char*>(m_cur), len);
+    m_cur += len;
+    return ret;
+  }
+  bool hasError() const { return m_error; }
+};
+} // namespace
+
+CookDatabase::CookDatabase(Project& project, const ProjectPath& dbPath)
+: m_project(project), m_dbPath(dbPath.getAbsolutePath()) {}
+
+void CookDatabase::load() {
+  std::unique_lock lk{m_lock};
+  m_stamps.clear();
+  m_records.clear();
+  m_depsRecords.clear();
+  m_cookDurations.clear();
+  m_dependents.clear();
+  m_dirty = false;
+
+  auto fp = hecl::FopenUnique(m_dbPath.c_str(), _SYS_STR("rb"));
+  if (!fp)
+    return;
+
+  std::vector<uint8_t> data;
+  uint8_t readBuf[65536];
+  size_t readSz;
+  while ((readSz = std::fread(readBuf, 1, sizeof(readBuf), fp.get())))
+    data.insert(data.end(), readBuf, readBuf + readSz);
+  fp.reset();
+
+  DBReader r(data);
+  hecl::FourCC magic;
+  r.readBytes(&magic, 4);
+  if (magic != CKDBfcc || r.readU32() != COOKDB_VERSION) {
+    Log.report(logvisor::Warning, FMT_STRING("discarding incompatible cook database; all objects will be recooked"));
+    return;
+  }
+
+  const uint32_t stampCount = r.readU32();
+  for (uint32_t i = 0; i < stampCount && !r.hasError(); ++i) {
+    const uint64_t pathHash = r.readU64();
+    FileStamp& stamp = m_stamps[pathHash];
+    stamp.modtime = time_t(r.readU64());
+    stamp.size = r.readU64();
+    stamp.contentHash = r.readU64();
+  }
+
+  const uint32_t recordCount = r.readU32();
+  for (uint32_t i = 0; i < recordCount && !r.hasError(); ++i) {
+    const uint64_t srcHash = r.readU64();
+    const uint64_t cookedHash = r.readU64();
+    Record& rec = m_records[std::make_pair(srcHash, cookedHash)];
+    rec.contentHash = r.readU64();
+    rec.specVersion = r.readU32();
+    rec.cookFormat = r.readU32();
+    const uint32_t depCount = r.readU32();
+    for (uint32_t j = 0; j < depCount && !r.hasError(); ++j) {
+      Dependency& dep = rec.deps.emplace_back();
+      dep.relPath = r.readString();
+      dep.contentHash = r.readU64();
+    }
+  }
+
+  const uint32_t depsRecordCount = r.readU32();
+  for (uint32_t i = 0; i < depsRecordCount && !r.hasError(); ++i) {
+    DepsRecord& rec = m_depsRecords[r.readU64()];
+    rec.contentHash = r.readU64();
+    const uint32_t depCount = r.readU32();
+    rec.deps.reserve(depCount);
+    for (uint32_t j = 0; j < depCount && !r.hasError(); ++j)
+      rec.deps.push_back(r.readString());
+  }
+
+  const uint32_t durationCount = r.readU32();
+  for (uint32_t i = 0; i < durationCount && !r.hasError(); ++i) {
+    const uint64_t pathHash = r.readU64();
+    m_cookDurations[pathHash] = r.readU32();
+  }
+
+  if (r.hasError()) {
+    Log.report(logvisor::Warning, FMT_STRING("cook database is truncated; all objects will be recooked"));
+    m_stamps.clear();
+    m_records.clear();
+    m_depsRecords.clear();
+    m_cookDurations.clear();
+  }
+}
+
+bool CookDatabase::commit() {
+  std::unique_lock lk{m_lock};
+  if (!m_dirty)
+    return true;
+
+  DBWriter w;
+  w.writeBytes(&CKDBfcc, 4);
+  w.writeU32(COOKDB_VERSION);
+
+  w.writeU32(uint32_t(m_stamps.size()));
+  for (const auto& [pathHash, stamp] : m_stamps) {
+    w.writeU64(pathHash);
+    w.writeU64(uint64_t(stamp.modtime));
+    w.writeU64(stamp.size);
+    w.writeU64(stamp.contentHash.val64());
+  }
+
+  w.writeU32(uint32_t(m_records.size()));
+  for (const auto& [key, rec] : m_records) {
+    w.writeU64(key.first);
+    w.writeU64(key.second);
+    w.writeU64(rec.contentHash.val64());
+    w.writeU32(rec.specVersion);
+    w.writeU32(rec.cookFormat);
+    w.writeU32(uint32_t(rec.deps.size()));
+    for (const Dependency& dep : rec.deps) {
+      w.writeString(dep.relPath);
+      w.writeU64(dep.contentHash.val64());
+    }
+  }
+
+  w.writeU32(uint32_t(m_depsRecords.size()));
+  for (const auto& [pathHash, rec] : m_depsRecords) {
+    w.writeU64(pathHash);
+    w.writeU64(rec.contentHash.val64());
+    w.writeU32(uint32_t(rec.deps.size()));
+    for (const std::string& dep : rec.deps)
+      w.writeString(dep);
+  }
+
+  w.writeU32(uint32_t(m_cookDurations.size()));
+  for (const auto& [pathHash, ms] : m_cookDurations) {
+    w.writeU64(pathHash);
+    w.writeU32(ms);
+  }
+
+  const SystemString newPath = m_dbPath + _SYS_STR(".part");
+  auto fp = hecl::FopenUnique(newPath.c_str(), _SYS_STR("wb"), FileLockType::Write);
+  if (!fp) {
+    Log.report(logvisor::Error, FMT_STRING(_SYS_STR("unable to open {} for writing")), newPath);
+    return false;
+  }
+  const bool fail = std::fwrite(w.data().data(), 1, w.data().size(), fp.get()) != w.data().size();
+  fp.reset();
+  if (fail) {
+    hecl::Unlink(newPath.c_str());
+    return false;
+  }
+  if (hecl::Rename(newPath.c_str(), m_dbPath.c_str()))
+    return false;
+
+  m_dirty = false;
+  return true;
+}
+
+Hash CookDatabase::hashFile(const ProjectPath& path, SystemStringView absPath) {
+  Sstat theStat;
+  if (hecl::Stat(absPath.data(), &theStat) || !S_ISREG(theStat.st_mode))
+    return {};
+
+  const uint64_t pathHash = path.hash().val64();
+  {
+    std::unique_lock lk{m_lock};
+    auto search = m_stamps.find(pathHash);
+    if (search != m_stamps.end() && search->second.modtime == theStat.st_mtime &&
+        search->second.size == uint64_t(theStat.st_size))
+      return search->second.contentHash;
+  }
+
+  /* Files modified within the current second may change again without
+   * affecting the stamp; don't let the stamp vouch for them next time */
+  const time_t hashTime = std::time(nullptr);
+
+  auto fp = hecl::FopenUnique(absPath.data(), _SYS_STR("rb"));
+  if (!fp)
+    return {};
+  XXH64_state_t st;
+  XXH64_reset(&st, 0);
+  uint8_t readBuf[65536];
+  size_t readSz;
+  while ((readSz = std::fread(readBuf, 1, sizeof(readBuf), fp.get())))
+    XXH64_update(&st, readBuf, readSz);
+  fp.reset();
+  Hash ret(XXH64_digest(&st));
+
+  std::unique_lock lk{m_lock};
+  FileStamp& stamp = m_stamps[pathHash];
+  stamp.modtime = theStat.st_mtime < hashTime ? theStat.st_mtime : 0;
+  stamp.size = uint64_t(theStat.st_size);
+  stamp.contentHash = ret;
+  m_dirty = true;
+  return ret;
+}
+
+Hash CookDatabase::hashContents(const ProjectPath& path) {
+  switch (path.getPathType()) {
+  case ProjectPath::Type::File:
+    return hashFile(path, path.getAbsolutePath());
+  case ProjectPath::Type::Directory: {
+    XXH64_state_t st;
+    XXH64_reset(&st, 0);
+    hecl::DirectoryEnumerator de(path.getAbsolutePath(), hecl::DirectoryEnumerator::Mode::FilesSorted, false, false,
+                                 true);
+    for (const hecl::DirectoryEnumerator::Entry& ent : de) {
+      const uint64_t fileHash = hashFile(ProjectPath(path, ent.m_name), ent.m_path).val64();
+      XXH64_update(&st, ent.m_name.data(), ent.m_name.size() * sizeof(SystemChar));
+      XXH64_update(&st, &fileHash, sizeof(fileHash));
+    }
+    return XXH64_digest(&st);
+  }
+  case ProjectPath::Type::Glob: {
+    XXH64_state_t st;
+    XXH64_reset(&st, 0);
+    std::vector<ProjectPath> globResults;
+    path.getGlobResults(globResults);
+    for (const ProjectPath& result : globResults) {
+      const uint64_t fileHash = hashFile(result, result.getAbsolutePath()).val64();
+      const auto relPath = result.getRelativePathUTF8();
+      XXH64_update(&st, relPath.data(), relPath.size());
+      XXH64_update(&st, &fileHash, sizeof(fileHash));
+    }
+    return XXH64_digest(&st);
+  }
+  default:
+    return {};
+  }
+}
+
+bool CookDatabase::isUpToDate(const ProjectPath& path, const ProjectPath& cookedPath, uint32_t specVersion,
+                              Hash& contentHashOut) {
+  contentHashOut = hashContents(path);
+  if (cookedPath.getPathType() == ProjectPath::Type::None)
+    return false;
+
+  std::vector<Dependency> deps;
+  bool match;
+  {
+    std::unique_lock lk{m_lock};
+    auto search = m_records.find(std::make_pair(path.hash().val64(), cookedPath.hash().val64()));
+    if (search == m_records.end())
+      return false;
+    const Record& rec = search->second;
+    match = rec.specVersion == specVersion && rec.cookFormat == CookFormatVersion &&
+            rec.contentHash == contentHashOut;
+    deps = rec.deps;
+  }
+
+  std::vector<ProjectPath> depPaths;
+  depPaths.reserve(deps.size());
+  for (const Dependency& dep : deps)
+    depPaths.emplace_back(m_project, dep.relPath);
+  indexDependents(path, depPaths);
+  if (!match)
+    return false;
+
+  for (size_t i = 0; i < deps.size(); ++i)
+    if (hashContents(depPaths[i]) != deps[i].contentHash)
+      return false;
+
+  return true;
+}
+
+void CookDatabase::recordCook(const ProjectPath& path, const ProjectPath& cookedPath, uint32_t specVersion,
+                              Hash contentHash, const std::vector<ProjectPath>& deps) {
+  Record rec;
+  rec.contentHash = contentHash;
+  rec.specVersion = specVersion;
+  rec.cookFormat = CookFormatVersion;
+  rec.deps.reserve(deps.size());
+  for (const ProjectPath& dep : deps)
+    rec.deps.push_back({std::string(dep.getRelativePathUTF8()), hashContents(dep)});
+  indexDependents(path, deps);
+
+  std::unique_lock lk{m_lock};
+  m_records[std::make_pair(path.hash().val64(), cookedPath.hash().val64())] = std::move(rec);
+  m_dirty = true;
+}
+
+void CookDatabase::indexDependents(const ProjectPath& path, const std::vector<ProjectPath>& deps) {
+  std::unique_lock lk{m_lock};
+  for (const ProjectPath& dep : deps) {
+    std::vector<ProjectPath>& dependents = m_dependents[dep.hash().val64()];
+    if (std::find(dependents.begin(), dependents.end(), path) == dependents.end())
+      dependents.push_back(path);
+  }
+}
+
+void CookDatabase::getDependents(const ProjectPath& path, std::vector<ProjectPath>& dependentsOut) const {
+  std::unique_lock lk{m_lock};
+  auto search = m_dependents.find(path.hash().val64());
+  if (search != m_dependents.end())
+    dependentsOut.insert(dependentsOut.end(), search->second.begin(), search->second.end());
+}
+
+bool CookDatabase::lookupDeps(const ProjectPath& path, Hash contentHash, std::vector<ProjectPath>& depsOut) const {
+  std::vector<std::string> deps;
+  {
+    std::unique_lock lk{m_lock};
+    auto search = m_depsRecords.find(path.hash().val64());
+    if (search == m_depsRecords.end() || search->second.contentHash != contentHash)
+      return false;
+    deps = search->second.deps;
+  }
+
+  depsOut.reserve(depsOut.size() + deps.size());
+  for (const std::string& dep : deps)
+    depsOut.emplace_back(m_project, dep);
+  return true;
+}
+
+bool CookDatabase::recordDeps(const ProjectPath& path, Hash contentHash, const std::vector<ProjectPath>& deps) {
+  DepsRecord rec;
+  rec.contentHash = contentHash;
+  rec.deps.reserve(deps.size());
+  for (const ProjectPath& dep : deps)
+    rec.deps.emplace_back(dep.getRelativePathUTF8());
+
+  std::unique_lock lk{m_lock};
+  DepsRecord& existing = m_depsRecords[path.hash().val64()];
+  if (existing.contentHash == rec.contentHash && existing.deps == rec.deps)
+    return false;
+  existing = std::move(rec);
+  m_dirty = true;
+  return true;
+}
+
+bool CookDatabase::lookupCookDuration(const ProjectPath& path, uint32_t& msOut) const {
+  std::unique_lock lk{m_lock};
+  auto search = m_cookDurations.find(path.hash().val64());
+  if (search == m_cookDurations.end())
+    return false;
+  msOut = search->second;
+  return true;
+}
+
+void CookDatabase::recordCookDuration(const ProjectPath& path, uint32_t ms) {
+  std::unique_lock lk{m_lock};
+  m_cookDurations[path.hash().val64()] = ms;
+  m_dirty = true;
+}
+
+} // namespace hecl::Database
@@ -2,10 +2,16 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <system_error>
+#include <unordered_map>
+#include <unordered_set>
 
 #if _WIN32
 #else
@@ -175,6 +181,7 @@ Project::Project(const ProjectRootPath& rootPath)
 , m_workRoot(*this, _SYS_STR(""))
 , m_dotPath(m_workRoot, _SYS_STR(".hecl"))
 , m_cookedRoot(m_dotPath, _SYS_STR("cooked"))
+, m_cookDatabase(*this, ProjectPath(m_dotPath, _SYS_STR("cookdb")))
 , m_specs(*this, _SYS_STR("specs"))
 , m_paths(*this, _SYS_STR("paths"))
 , m_groups(*this, _SYS_STR("groups")) {
@@ -218,9 +225,17 @@ Project::Project(const ProjectRootPath& rootPath)
 
   /* Compile current dataspec */
   rescanDataSpecs();
+
+  /* Load record of previous cooks */
+  m_cookDatabase.load();
   m_valid = true;
 }
 
+Project::~Project() {
+  if (m_valid)
+    m_cookDatabase.commit();
+}
+
 const ProjectPath& Project::getProjectCookedPath(const DataSpecEntry& spec) const {
   for (const ProjectDataSpec& sp : m_compiledSpecs)
     if (&sp.spec == &spec)
@@ -336,27 +351,43 @@ public:
   void reportDirComplete() { m_progPrinter.print(m_dir, nullptr, 1.f); }
 };
 
+static void CookFile(const ProjectPath& path, bool force, bool fast, IDataSpec& spec, CookProgress& progress,
+                     ClientProcess* cp) {
+  if (!spec.canCook(path, hecl::blender::SharedBlenderToken))
+    return;
+  if (cp) {
+    cp->addCookTransaction(path, force, fast, &spec);
+    return;
+  }
+
+  const DataSpecEntry* override = spec.overrideDataSpec(path, spec.getDataSpecEntry());
+  if (!override)
+    return;
+  ProjectPath cooked = path.getCookedPath(*override);
+  if (fast)
+    cooked = cooked.getWithExtension(_SYS_STR(".fast"));
+  CookDatabase& cookDb = path.getProject().getCookDatabase();
+  Hash contentHash;
+  const uint32_t cookVersion = spec.getCookVersion();
+  if (!cookDb.isUpToDate(path, cooked, cookVersion, contentHash) || force) {
+    progress.reportFile(override);
+    const auto cookStart = std::chrono::steady_clock::now();
+    spec.doCook(path, cooked, fast, hecl::blender::SharedBlenderToken,
+                [&](const SystemChar* extra) { progress.reportFile(override, extra); });
+    cooked.invalidateStat();
+    const auto cookMs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - cookStart);
+    std::vector<ProjectPath> deps;
+    spec.getCookDependencies(path, deps);
+    cookDb.recordCook(path, cooked, cookVersion, contentHash, deps);
+    cookDb.recordCookDuration(path, uint32_t(cookMs.count()));
+  }
+}
+
 static void VisitFile(const ProjectPath& path, bool force, bool fast,
                       std::vector<std::unique_ptr<IDataSpec>>& specInsts, CookProgress& progress, ClientProcess* cp) {
-  for (auto& spec : specInsts) {
-    if (spec->canCook(path, hecl::blender::SharedBlenderToken)) {
-      if (cp) {
-        cp->addCookTransaction(path, force, fast, spec.get());
-      } else {
-        const DataSpecEntry* override = spec->overrideDataSpec(path, spec->getDataSpecEntry());
-        if (!override)
-          continue;
-        ProjectPath cooked = path.getCookedPath(*override);
-        if (fast)
-          cooked = cooked.getWithExtension(_SYS_STR(".fast"));
-        if (force || cooked.getPathType() == ProjectPath::Type::None || path.getModtime() > cooked.getModtime()) {
-          progress.reportFile(override);
-          spec->doCook(path, cooked, fast, hecl::blender::SharedBlenderToken,
-                       [&](const SystemChar* extra) { progress.reportFile(override, extra); });
-        }
-      }
-    }
-  }
+  for (auto& spec : specInsts)
+    CookFile(path, force, fast, *spec, progress, cp);
 }
 
 static void VisitDirectory(const ProjectPath& dir, bool recursive, bool force, bool fast,
@@ -408,6 +439,68 @@ static void VisitDirectory(const ProjectPath& dir, bool recursive, bool force, b
   }
 }
 
+namespace {
+/* Streams a directory tree into a ClientProcess. Each directory is enumerated once by its own
+ * worker transaction (reusing the enumerator's file/directory classification rather than
+ * re-stat'ing children) and cookable files are queued as soon as they are seen. */
+class CookCrawler : public std::enable_shared_from_this<CookCrawler> {
+  ClientProcess& m_cp;
+  std::vector<std::unique_ptr<IDataSpec>>& m_specInsts;
+  bool m_recursive;
+  bool m_force;
+  bool m_fast;
+
+  void visitFile(const ProjectPath& path, hecl::blender::Token& btok) {
+    for (auto& spec : m_specInsts)
+      if (spec->canCook(path, btok))
+        m_cp.addCookTransaction(path, m_force, m_fast, spec.get());
+  }
+
+  void visitDirectory(const ProjectPath& dir, hecl::blender::Token& btok) {
+    for (auto& spec : m_specInsts)
+      spec->setThreadProject();
+
+    hecl::DirectoryEnumerator de(dir.getAbsolutePath(), hecl::DirectoryEnumerator::Mode::Native, false, false, true);
+
+    /* Handle AudioGroup case */
+    bool hasProjectYaml = false;
+    bool hasPoolYaml = false;
+    for (const hecl::DirectoryEnumerator::Entry& ent : de) {
+      if (ent.m_isDir)
+        continue;
+      if (ent.m_name == _SYS_STR("!project.yaml"))
+        hasProjectYaml = true;
+      else if (ent.m_name == _SYS_STR("!pool.yaml"))
+        hasPoolYaml = true;
+    }
+    if (hasProjectYaml && hasPoolYaml) {
+      visitFile(dir, btok);
+      return;
+    }
+
+    for (const hecl::DirectoryEnumerator::Entry& ent : de) {
+      if (ent.m_isDir) {
+        if (m_recursive)
+          queueDirectory(ProjectPath(dir, ent.m_name));
+      } else {
+        visitFile(ProjectPath(dir, ent.m_name), btok);
+      }
+    }
+  }
+
+public:
+  CookCrawler(ClientProcess& cp, std::vector<std::unique_ptr<IDataSpec>>& specInsts, bool recursive, bool force,
+              bool fast)
+  : m_cp(cp), m_specInsts(specInsts), m_recursive(recursive), m_force(force), m_fast(fast) {}
+
+  void queueDirectory(ProjectPath dir) {
+    m_cp.addLambdaTransaction([self = shared_from_this(), dir = std::move(dir)](hecl::blender::Token& btok) {
+      self->visitDirectory(dir, btok);
+    });
+  }
+};
+} // namespace
+
 bool Project::cookPath(const ProjectPath& path, const hecl::MultiProgressPrinter& progress, bool recursive, bool force,
                        bool fast, const DataSpecEntry* spec, ClientProcess* cp) {
   /* Construct DataSpec instances for cooking */
@@ -436,60 +529,351 @@ bool Project::cookPath(const ProjectPath& path, const hecl::MultiProgressPrinter
     break;
   }
   case ProjectPath::Type::Directory: {
-    VisitDirectory(path, recursive, force, fast, m_cookSpecs, cookProg, cp);
+    if (cp) {
+      if (path.getLastComponent().size() > 1 && path.getLastComponent()[0] == _SYS_STR('.'))
+        break;
+      std::make_shared<CookCrawler>(*cp, m_cookSpecs, recursive, force, fast)->queueDirectory(path);
+    } else {
+      VisitDirectory(path, recursive, force, fast, m_cookSpecs, cookProg, cp);
+    }
     break;
   }
   default:
     break;
   }
 
+  /* Asynchronous cooks are committed by the caller once the ClientProcess drains */
+  if (!cp)
+    m_cookDatabase.commit();
+
   return true;
 }
 
-bool Project::packagePath(const ProjectPath& path, const hecl::MultiProgressPrinter& progress, bool fast,
-                          const DataSpecEntry* spec, ClientProcess* cp) {
-  /* Construct DataSpec instance for packaging */
+const DataSpecEntry* Project::selectPackageSpec(const DataSpecEntry* spec) const {
+  if (spec)
+    return spec->m_factory ? spec : nullptr;
+
   const DataSpecEntry* specEntry = nullptr;
-  if (spec) {
-    if (spec->m_factory) {
-      specEntry = spec;
-    }
-  } else {
-    bool foundPC = false;
-    for (const ProjectDataSpec& projectSpec : m_compiledSpecs) {
-      if (projectSpec.active && projectSpec.spec.m_factory) {
-        if (hecl::StringUtils::EndsWith(projectSpec.spec.m_name, _SYS_STR("-PC"))) {
-          foundPC = true;
-          specEntry = &projectSpec.spec;
-        } else if (!foundPC) {
-          specEntry = &projectSpec.spec;
-        }
+  bool foundPC = false;
+  for (const ProjectDataSpec& projectSpec : m_compiledSpecs) {
+    if (projectSpec.active && projectSpec.spec.m_factory) {
+      if (hecl::StringUtils::EndsWith(projectSpec.spec.m_name, _SYS_STR("-PC"))) {
+        foundPC = true;
+        specEntry = &projectSpec.spec;
+      } else if (!foundPC) {
+        specEntry = &projectSpec.spec;
       }
     }
   }
+  return specEntry;
+}
 
+bool Project::packagePath(const ProjectPath& path, const hecl::MultiProgressPrinter& progress, bool fast,
+                          const DataSpecEntry* spec, ClientProcess* cp) {
+  /* Construct DataSpec instance for packaging */
+  const DataSpecEntry* specEntry = selectPackageSpec(spec);
   if (!specEntry)
     LogModule.report(logvisor::Fatal, FMT_STRING("No matching DataSpec"));
 
   if (!m_lastPackageSpec || m_lastPackageSpec->getDataSpecEntry() != specEntry)
     m_lastPackageSpec = specEntry->m_factory(*this, DataSpecTool::Package);
 
-  if (m_lastPackageSpec->canPackage(path)) {
-    m_lastPackageSpec->doPackage(path, specEntry, fast, hecl::blender::SharedBlenderToken, progress, cp);
-    return true;
-  }
+  if (!m_lastPackageSpec->canPackage(path))
+    return false;
+  m_packageInterrupted = false;
 
-  return false;
+  /* Cook changed dependencies leaves-first; unchanged subtrees were cooked by a previous package */
+  PackageDepsgraph graph = buildPackageDepsgraph(path, specEntry, cp);
+  CookProgress cookProg(progress);
+  graph.visitChangedLeavesFirst([&](const PackageDepsgraph::Node& node) {
+    if (node.type != PackageDepsgraph::Node::Type::Data || !node.cookedPath)
+      return;
+    cookProg.changeFile(node.path.getLastComponent().data(), 0.f);
+    CookFile(node.path, false, fast, *m_lastPackageSpec, cookProg, cp);
+  });
+  if (cp)
+    cp->waitUntilComplete();
+
+  m_lastPackageSpec->doPackage(path, specEntry, fast, hecl::blender::SharedBlenderToken, progress, cp);
+  if (!m_packageInterrupted)
+    recordPackageDepsgraph(graph);
+  m_cookDatabase.commit();
+  return true;
 }
 
 void Project::interruptCook() {
+  m_packageInterrupted = true;
   if (m_lastPackageSpec)
     m_lastPackageSpec->interruptCook();
 }
 
 bool Project::cleanPath(const ProjectPath& path, bool recursive) { return false; }
 
-PackageDepsgraph Project::buildPackageDepsgraph(const ProjectPath& path) { return PackageDepsgraph(); }
+/**********************************************
+ * PackageDepsgraph
+ **********************************************/
+
+PackageDepsgraph::PackageDepsgraph() = default;
+PackageDepsgraph::~PackageDepsgraph() = default;
+PackageDepsgraph::PackageDepsgraph(PackageDepsgraph&&) noexcept = default;
+PackageDepsgraph& PackageDepsgraph::operator=(PackageDepsgraph&&) noexcept = default;
+
+std::unique_ptr<ObjectBase> IDataSpec::buildProjectObject(const ProjectPath&) { return {}; }
+
+namespace {
+struct DepsgraphEntry {
+  ProjectPath path;
+  ObjectBase* obj = nullptr;
+  bool isGroup = false;
+  bool changed = false;
+  Hash contentHash;
+  std::vector<DepsgraphEntry*> children;
+};
+
+/* Discovers every path reachable from the root, expanding each one exactly once.
+ * Expansions are dispatched to ClientProcess workers when available. */
+class DepsgraphBuilder {
+public:
+  using FGatherDeps = std::function<void(ObjectBase&, std::vector<ObjectBase*>&)>;
+
+private:
+  Project& m_project;
+  IDataSpec* m_spec;
+  ClientProcess* m_cp;
+  FGatherDeps m_gatherDeps;
+  std::vector<std::unique_ptr<ObjectBase>>& m_objects;
+  std::mutex m_lock;
+  std::deque<DepsgraphEntry> m_entries;
+  std::unordered_map<uint64_t, DepsgraphEntry*> m_entryMap;
+  std::vector<DepsgraphEntry*> m_serialStack;
+
+  static bool IsAudioGroup(const ProjectPath& dir) {
+    return ProjectPath(dir, _SYS_STR("!project.yaml")).isFile() && ProjectPath(dir, _SYS_STR("!pool.yaml")).isFile();
+  }
+
+  void addChild(DepsgraphEntry& parent, const ProjectPath& path, ObjectBase* obj, bool isGroup) {
+    std::unique_lock lk{m_lock};
+    auto [it, inserted] = m_entryMap.try_emplace(path.hash().val64(), nullptr);
+    if (inserted) {
+      DepsgraphEntry& entry = m_entries.emplace_back();
+      entry.path = path;
+      entry.obj = obj;
+      entry.isGroup = isGroup;
+      it->second = &entry;
+    }
+    DepsgraphEntry* child = it->second;
+    lk.unlock();
+    parent.children.push_back(child);
+    if (inserted)
+      schedule(*child);
+  }
+
+  void schedule(DepsgraphEntry& entry) {
+    if (m_cp)
+      m_cp->addLambdaTransaction([this, &entry](blender::Token& btok) { expand(entry, btok); });
+    else
+      m_serialStack.push_back(&entry);
+  }
+
+  /* A node is changed when its content differs from the recorded graph, or when it gained or
+   * lost dependencies (including deleted children) since then */
+  bool depsChanged(const DepsgraphEntry& entry, const std::vector<ProjectPath>& deps) const {
+    std::vector<ProjectPath> recordedDeps;
+    if (!m_project.getCookDatabase().lookupDeps(entry.path, entry.contentHash, recordedDeps))
+      return true;
+    return recordedDeps != deps;
+  }
+
+  void expandGroup(DepsgraphEntry& entry) {
+    std::vector<ProjectPath> children;
+    if (entry.path.getPathType() == ProjectPath::Type::Glob) {
+      entry.path.getGlobResults(children);
+      entry.changed = depsChanged(entry, children);
+      for (const ProjectPath& result : children)
+        addChild(entry, result, nullptr, false);
+      return;
+    }
+
+    hecl::DirectoryEnumerator de(entry.path.getAbsolutePath(), hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted,
+                                 false, false, true);
+    children.reserve(de.size());
+    for (const hecl::DirectoryEnumerator::Entry& ent : de)
+      children.emplace_back(entry.path, ent.m_name);
+    entry.changed = depsChanged(entry, children);
+    size_t i = 0;
+    for (const hecl::DirectoryEnumerator::Entry& ent : de) {
+      const ProjectPath& child = children[i++];
+      addChild(entry, child, nullptr, ent.m_isDir && !IsAudioGroup(child));
+    }
+  }
+
+  void expand(DepsgraphEntry& entry, blender::Token& btok) {
+    if (entry.isGroup) {
+      expandGroup(entry);
+      return;
+    }
+
+    CookDatabase& cookDb = m_project.getCookDatabase();
+    entry.contentHash = cookDb.hashContents(entry.path);
+    std::vector<ProjectPath> cachedDeps;
+    entry.changed = !cookDb.lookupDeps(entry.path, entry.contentHash, cachedDeps);
+
+    /* Project object dependencies */
+    std::vector<ProjectPath> deps;
+    std::vector<ObjectBase*> depObjs;
+    if (m_spec) {
+      m_spec->setThreadProject();
+      if (!entry.obj) {
+        if (std::unique_ptr<ObjectBase> obj = m_spec->buildProjectObject(entry.path)) {
+          entry.obj = obj.get();
+          std::unique_lock lk{m_lock};
+          m_objects.push_back(std::move(obj));
+        }
+      }
+      if (entry.obj) {
+        m_gatherDeps(*entry.obj, depObjs);
+        for (ObjectBase* dep : depObjs)
+          deps.emplace_back(m_project, dep->getPath());
+      }
+    }
+
+    /* Blender texture dependencies; only re-opened if the blend changed */
+    if (hecl::IsPathBlend(entry.path)) {
+      if (entry.changed) {
+        blender::Connection& conn = btok.getBlenderConnection();
+        if (conn.openBlend(entry.path)) {
+          blender::DataStream ds = conn.beginData();
+          for (ProjectPath& tex : ds.getTextures())
+            if (tex)
+              deps.push_back(std::move(tex));
+        }
+      } else {
+        deps.insert(deps.end(), cachedDeps.begin(), cachedDeps.end());
+      }
+    }
+
+    std::unordered_set<uint64_t> seenDeps;
+    std::vector<ProjectPath> uniqueDeps;
+    std::vector<ObjectBase*> uniqueDepObjs;
+    uniqueDeps.reserve(deps.size());
+    uniqueDepObjs.reserve(deps.size());
+    for (size_t i = 0; i < deps.size(); ++i) {
+      if (!deps[i] || !seenDeps.insert(deps[i].hash().val64()).second)
+        continue;
+      uniqueDeps.push_back(std::move(deps[i]));
+      uniqueDepObjs.push_back(i < depObjs.size() ? depObjs[i] : nullptr);
+    }
+    if (!entry.changed)
+      entry.changed = cachedDeps != uniqueDeps;
+    for (size_t i = 0; i < uniqueDeps.size(); ++i)
+      addChild(entry, uniqueDeps[i], uniqueDepObjs[i], false);
+  }
+
+public:
+  DepsgraphBuilder(Project& project, IDataSpec* spec, ClientProcess* cp, FGatherDeps gatherDeps,
+                   std::vector<std::unique_ptr<ObjectBase>>& objects)
+  : m_project(project), m_spec(spec), m_cp(cp), m_gatherDeps(std::move(gatherDeps)), m_objects(objects) {}
+
+  DepsgraphEntry* run(const ProjectPath& root) {
+    DepsgraphEntry& rootEntry = m_entries.emplace_back();
+    rootEntry.path = root;
+    switch (root.getPathType()) {
+    case ProjectPath::Type::Directory:
+      rootEntry.isGroup = !IsAudioGroup(root);
+      break;
+    case ProjectPath::Type::Glob:
+      rootEntry.isGroup = true;
+      break;
+    default:
+      break;
+    }
+    m_entryMap[root.hash().val64()] = &rootEntry;
+
+    schedule(rootEntry);
+    if (m_cp) {
+      m_cp->waitUntilComplete();
+    } else {
+      while (!m_serialStack.empty()) {
+        DepsgraphEntry* entry = m_serialStack.back();
+        m_serialStack.pop_back();
+        expand(*entry, hecl::blender::SharedBlenderToken);
+      }
+    }
+    return &rootEntry;
+  }
+};
+} // namespace
+
+PackageDepsgraph Project::buildPackageDepsgraph(const ProjectPath& path, const DataSpecEntry* spec,
+                                                ClientProcess* cp) {
+  PackageDepsgraph graph;
+
+  const DataSpecEntry* specEntry = selectPackageSpec(spec);
+  if (specEntry && (!m_lastPackageSpec || m_lastPackageSpec->getDataSpecEntry() != specEntry))
+    m_lastPackageSpec = specEntry->m_factory(*this, DataSpecTool::Package);
+  IDataSpec* specInst = specEntry ? m_lastPackageSpec.get() : nullptr;
+
+  /* Pass 1: discover dependencies (in parallel if possible) */
+  DepsgraphBuilder builder(*this, specInst, cp,
+                           [](ObjectBase& obj, std::vector<ObjectBase*>& depsOut) {
+                             obj.gatherDeps([&](ObjectBase* dep) {
+                               if (dep && !dep->getPath().empty())
+                                 depsOut.push_back(dep);
+                             });
+                           },
+                           graph.m_objects);
+  DepsgraphEntry* rootEntry = builder.run(path);
+
+  /* Pass 2: emit node tree depth-first, expanding each path at its first occurrence */
+  std::unordered_map<uint64_t, bool> expanded;
+  auto emit = [&](auto& self, DepsgraphEntry* entry) -> PackageDepsgraph::Node* {
+    PackageDepsgraph::Node& node = graph.m_nodes.emplace_back();
+    node.type = entry->isGroup ? PackageDepsgraph::Node::Type::Group : PackageDepsgraph::Node::Type::Data;
+    node.path = entry->path;
+    node.projectObj = entry->obj;
+    node.contentHash = entry->contentHash;
+    if (specInst && !entry->isGroup) {
+      if (const DataSpecEntry* cookEntry = specInst->overrideDataSpec(entry->path, specEntry))
+        node.cookedPath = entry->path.getCookedPath(*cookEntry);
+    }
+
+    const uint64_t pathHash = entry->path.hash().val64();
+    if (auto search = expanded.find(pathHash); search != expanded.end()) {
+      node.changed = search->second;
+      return &node;
+    }
+    expanded[pathHash] = entry->changed;
+
+    bool changed = entry->changed;
+    PackageDepsgraph::Node* prev = nullptr;
+    for (DepsgraphEntry* child : entry->children) {
+      PackageDepsgraph::Node* childNode = self(self, child);
+      if (prev)
+        prev->next = childNode;
+      else
+        node.sub = childNode;
+      prev = childNode;
+      changed |= childNode->changed;
+    }
+    node.changed = changed;
+    expanded[pathHash] = changed;
+    return &node;
+  };
+  emit(emit, rootEntry);
+
+  return graph;
+}
+
+void Project::recordPackageDepsgraph(const PackageDepsgraph& graph) {
+  /* Each unique path is visited at its expanded occurrence, so its sub list is its full dependency list */
+  std::vector<ProjectPath> deps;
+  graph.visitLeavesFirst([&](const PackageDepsgraph::Node& node) {
+    deps.clear();
+    for (const PackageDepsgraph::Node* sub = node.sub; sub; sub = sub->next)
+      deps.push_back(sub->path);
+    m_cookDatabase.recordDeps(node.path, node.contentHash, deps);
+  });
+}
 
 void Project::addBridgePathToCache(uint64_t id, const ProjectPath& path) { m_bridgePathCache[id] = path; }
 
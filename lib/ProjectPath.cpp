@@ -1,48 +1,183 @@
 #include "hecl/hecl.hpp"
 
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <regex>
+#include <shared_mutex>
+#include <unordered_map>
 
 #include "hecl/Database.hpp"
 #include "hecl/FourCC.hpp"
 
 namespace hecl {
-static const SystemRegex regPATHCOMP(_SYS_STR("[/\\\\]*([^/\\\\]+)"), SystemRegex::ECMAScript | SystemRegex::optimize);
-
-static SystemString CanonRelPath(SystemStringView path) {
-  /* Tokenize Path */
-  std::vector<SystemString> comps;
-  hecl::SystemRegexMatch matches;
-  SystemString in(path);
-  SanitizePath(in);
-  for (; std::regex_search(in, matches, regPATHCOMP); in = matches.suffix().str()) {
-    hecl::SystemRegexMatch::const_reference match = matches[1];
-    if (match == _SYS_STR("."))
+const ProjectPath::Interned ProjectPath::Interned::Empty{};
+
+namespace {
+constexpr bool IsPathSep(SystemChar ch) { return ch == _SYS_STR('/') || ch == _SYS_STR('\\'); }
+
+/* Splits the first component off path, skipping leading separators */
+bool NextPathComponent(SystemStringView path, SystemStringView& compOut, SystemStringView& restOut) {
+  size_t begin = 0;
+  while (begin < path.size() && IsPathSep(path[begin]))
+    ++begin;
+  if (begin == path.size())
+    return false;
+  size_t end = begin;
+  while (end < path.size() && !IsPathSep(path[end]))
+    ++end;
+  compOut = path.substr(begin, end - begin);
+  restOut = path.substr(end);
+  return true;
+}
+
+/**
+ * Process-wide store of canonical path strings. Entries and their characters live in
+ * append-only blocks, so Interned pointers and views stay valid until exit.
+ */
+class PathInterner {
+  static constexpr size_t BlockSize = 64 * 1024;
+
+  std::shared_mutex m_lock;
+  std::deque<ProjectPath::Interned> m_entries;
+  std::unordered_multimap<uint64_t, const ProjectPath::Interned*> m_lookup;
+  std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+  uint8_t* m_block = nullptr;
+  size_t m_blockUsed = BlockSize;
+
+  template <typename CharT>
+  std::basic_string_view<CharT> store(std::basic_string_view<CharT> str) {
+    const size_t bytes = (str.size() + 1) * sizeof(CharT);
+    uint8_t* mem;
+    if (bytes > BlockSize / 4) {
+      mem = m_blocks.emplace_back(new uint8_t[bytes]).get();
+    } else {
+      m_blockUsed = (m_blockUsed + alignof(CharT) - 1) & ~(alignof(CharT) - 1);
+      if (m_blockUsed + bytes > BlockSize) {
+        m_block = m_blocks.emplace_back(new uint8_t[BlockSize]).get();
+        m_blockUsed = 0;
+      }
+      mem = m_block + m_blockUsed;
+      m_blockUsed += bytes;
+    }
+    auto* chars = reinterpret_cast<CharT*>(mem);
+    std::char_traits<CharT>::copy(chars, str.data(), str.size());
+    chars[str.size()] = CharT(0);
+    return {chars, str.size()};
+  }
+
+  const ProjectPath::Interned* find(uint64_t hash, const ProjectRootPath& root, SystemStringView relPath,
+                                    SystemStringView auxInfo) const {
+    const auto [begin, end] = m_lookup.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+      const ProjectPath::Interned* entry = it->second;
+      if (entry->rootHash == root.hash() && entry->relPath == relPath && entry->auxInfo == auxInfo)
+        return entry;
+    }
+    return nullptr;
+  }
+
+public:
+  const ProjectPath::Interned* intern(const ProjectRootPath& root, SystemStringView relPath, SystemStringView auxInfo) {
+#if HECL_UCS2
+    const std::string utf8RelPath = WideToUTF8(relPath);
+    const std::string utf8AuxInfo = WideToUTF8(auxInfo);
+    const std::string_view hashRel = utf8RelPath;
+    const std::string_view hashAux = utf8AuxInfo;
+#else
+    const std::string_view hashRel = relPath;
+    const std::string_view hashAux = auxInfo;
+#endif
+    /* Same value as hashing "rel|aux" (or "rel" alone) in one piece */
+    XXH64_state_t st;
+    XXH64_reset(&st, 0);
+    XXH64_update(&st, hashRel.data(), hashRel.size());
+    if (!hashAux.empty()) {
+      XXH64_update(&st, "|", 1);
+      XXH64_update(&st, hashAux.data(), hashAux.size());
+    }
+    const uint64_t hash = XXH64_digest(&st);
+
+    {
+      std::shared_lock lk{m_lock};
+      if (const ProjectPath::Interned* entry = find(hash, root, relPath, auxInfo))
+        return entry;
+    }
+
+    SystemString absPath(root.getAbsolutePath());
+    absPath += _SYS_STR('/');
+    absPath += relPath;
+    SanitizePath(absPath);
+
+    std::unique_lock lk{m_lock};
+    if (const ProjectPath::Interned* entry = find(hash, root, relPath, auxInfo))
+      return entry;
+    ProjectPath::Interned& entry = m_entries.emplace_back();
+    entry.absPath = store<SystemChar>(absPath);
+    entry.relPath = store<SystemChar>(relPath);
+    entry.auxInfo = store<SystemChar>(auxInfo);
+#if HECL_UCS2
+    entry.utf8AbsPath = store<char>(WideToUTF8(absPath));
+    entry.utf8RelPath = store<char>(utf8RelPath);
+    entry.utf8AuxInfo = store<char>(utf8AuxInfo);
+#endif
+    entry.hash = hash;
+    entry.rootHash = root.hash();
+    m_lookup.emplace(hash, &entry);
+    return &entry;
+  }
+};
+
+PathInterner& GetPathInterner() {
+  static PathInterner Interner;
+  return Interner;
+}
+} // anonymous namespace
+
+/* Single pass over path appending canonical components to ret, which must already be
+ * canonical. Characters SanitizePath would reject are replaced or dropped the same way. */
+static SystemString CanonRelPath(SystemStringView path, SystemString ret = {}) {
+  if (ret == _SYS_STR("."))
+    ret.clear();
+  ret.reserve(ret.size() + path.size() + 1);
+  size_t i = 0;
+  while (i < path.size()) {
+    if (IsPathSep(path[i])) {
+      ++i;
       continue;
-    else if (match == _SYS_STR("..")) {
-      if (comps.empty()) {
+    }
+
+    const size_t mark = ret.size();
+    if (!ret.empty())
+      ret += _SYS_STR('/');
+    const size_t compStart = ret.size();
+    for (; i < path.size() && !IsPathSep(path[i]); ++i) {
+      SystemChar ch = path[i];
+      if (ch == _SYS_STR('\n') || ch == _SYS_STR('\r'))
+        continue;
+      if (ch == _SYS_STR('<') || ch == _SYS_STR('>') || ch == _SYS_STR('?') || ch == _SYS_STR('"'))
+        ch = _SYS_STR('_');
+      ret += ch;
+    }
+
+    const SystemStringView comp(ret.data() + compStart, ret.size() - compStart);
+    if (comp.empty() || comp == _SYS_STR(".")) {
+      ret.resize(mark);
+    } else if (comp == _SYS_STR("..")) {
+      ret.resize(mark);
+      if (ret.empty()) {
         /* Unable to resolve outside project */
         LogModule.report(logvisor::Fatal, FMT_STRING(_SYS_STR("Unable to resolve outside project root in {}")), path);
         return _SYS_STR(".");
       }
-      comps.pop_back();
-      continue;
+      const size_t slash = ret.rfind(_SYS_STR('/'));
+      ret.resize(slash == SystemString::npos ? 0 : slash);
     }
-    comps.push_back(match.str());
   }
 
-  /* Emit relative path */
-  if (comps.size()) {
-    auto it = comps.begin();
-    SystemString retval = *it;
-    for (++it; it != comps.end(); ++it) {
-      if ((*it).size()) {
-        retval += _SYS_STR('/');
-        retval += *it;
-      }
-    }
-    return retval;
-  }
-  return _SYS_STR(".");
+  if (ret.empty())
+    return _SYS_STR(".");
+  return ret;
 }
 
 static SystemString CanonRelPath(SystemStringView path, const ProjectRootPath& projectRoot) {
@@ -52,23 +187,21 @@ static SystemString CanonRelPath(SystemStringView path, const ProjectRootPath& p
   return CanonRelPath(path);
 }
 
-void ProjectPath::assign(Database::Project& project, SystemStringView path) {
-  m_proj = &project;
-
-  SystemString usePath;
-  size_t pipeFind = path.rfind(_SYS_STR('|'));
-  if (pipeFind != SystemString::npos) {
-    m_auxInfo.assign(path.cbegin() + pipeFind + 1, path.cend());
-    usePath.assign(path.cbegin(), path.cbegin() + pipeFind);
-  } else
-    usePath = path;
+std::pair<SystemStringView, SystemStringView> ProjectPath::SplitAuxInfo(SystemStringView path) {
+  const size_t pipeFind = path.rfind(_SYS_STR('|'));
+  if (pipeFind == SystemStringView::npos)
+    return {path, {}};
+  return {path.substr(0, pipeFind), path.substr(pipeFind + 1)};
+}
 
-  m_relPath = CanonRelPath(usePath, project.getProjectRootPath());
-  m_absPath = SystemString(project.getProjectRootPath().getAbsolutePath()) + _SYS_STR('/') + m_relPath;
-  SanitizePath(m_relPath);
-  SanitizePath(m_absPath);
+void ProjectPath::assignCanon(Database::Project& project, SystemString&& relPath, SystemStringView auxInfo) {
+  m_proj = &project;
+  m_path = GetPathInterner().intern(project.getProjectRootPath(), relPath, auxInfo);
+}
 
-  ComputeHash();
+void ProjectPath::assign(Database::Project& project, SystemStringView path) {
+  const auto [usePath, auxInfo] = SplitAuxInfo(path);
+  assignCanon(project, CanonRelPath(usePath, project.getProjectRootPath()), auxInfo);
 }
 
 #if HECL_UCS2
@@ -79,22 +212,8 @@ void ProjectPath::assign(Database::Project& project, std::string_view path) {
 #endif
 
 void ProjectPath::assign(const ProjectPath& parentPath, SystemStringView path) {
-  m_proj = parentPath.m_proj;
-
-  SystemString usePath;
-  size_t pipeFind = path.rfind(_SYS_STR('|'));
-  if (pipeFind != SystemString::npos) {
-    m_auxInfo.assign(path.cbegin() + pipeFind + 1, path.cend());
-    usePath.assign(path.cbegin(), path.cbegin() + pipeFind);
-  } else
-    usePath = path;
-
-  m_relPath = CanonRelPath(parentPath.m_relPath + _SYS_STR('/') + usePath);
-  m_absPath = SystemString(m_proj->getProjectRootPath().getAbsolutePath()) + _SYS_STR('/') + m_relPath;
-  SanitizePath(m_relPath);
-  SanitizePath(m_absPath);
-
-  ComputeHash();
+  const auto [usePath, auxInfo] = SplitAuxInfo(path);
+  assignCanon(*parentPath.m_proj, CanonRelPath(usePath, SystemString(parentPath.m_path->relPath)), auxInfo);
 }
 
 #if HECL_UCS2
@@ -105,29 +224,21 @@ void ProjectPath::assign(const ProjectPath& parentPath, std::string_view path) {
 #endif
 
 ProjectPath ProjectPath::getWithExtension(const SystemChar* ext, bool replace) const {
-  ProjectPath pp(*this);
-  if (replace) {
-    auto relIt = pp.m_relPath.end();
-    if (relIt != pp.m_relPath.begin())
-      --relIt;
-    auto absIt = pp.m_absPath.end();
-    if (absIt != pp.m_absPath.begin())
-      --absIt;
-    while (relIt != pp.m_relPath.begin() && *relIt != _SYS_STR('.') && *relIt != _SYS_STR('/')) {
-      --relIt;
-      --absIt;
-    }
-    if (*relIt == _SYS_STR('.') && relIt != pp.m_relPath.begin()) {
-      pp.m_relPath.resize(relIt - pp.m_relPath.begin());
-      pp.m_absPath.resize(absIt - pp.m_absPath.begin());
-    }
-  }
-  if (ext) {
-    pp.m_relPath += ext;
-    pp.m_absPath += ext;
+  if (!m_proj)
+    return *this;
+  SystemString relPath(m_path->relPath);
+  if (replace && !relPath.empty()) {
+    size_t i = relPath.size() - 1;
+    while (i != 0 && relPath[i] != _SYS_STR('.') && relPath[i] != _SYS_STR('/'))
+      --i;
+    if (i != 0 && relPath[i] == _SYS_STR('.'))
+      relPath.resize(i);
   }
+  if (ext)
+    relPath += ext;
 
-  pp.ComputeHash();
+  ProjectPath pp;
+  pp.assignCanon(*m_proj, std::move(relPath), m_path->auxInfo);
   return pp;
 }
 
@@ -141,113 +252,314 @@ ProjectPath ProjectPath::getCookedPath(const Database::DataSpecEntry& spec) cons
     return ret;
 }
 
+std::atomic_uint32_t StatCacheSession::Depth = 0;
+std::atomic_uint64_t StatCacheSession::Epoch = 1;
+
+StatCacheSession::StatCacheSession() {
+  if (Depth.fetch_add(1, std::memory_order_acq_rel) == 0)
+    Invalidate();
+}
+
+StatCacheSession::~StatCacheSession() { Depth.fetch_sub(1, std::memory_order_acq_rel); }
+
+/* Stats absPath, or answers from the interned entry if it was stat'ed in this epoch */
+static ProjectPath::Type StatPath(const ProjectPath::Interned& path, time_t& modtimeOut) {
+  const uint64_t epoch = StatCacheSession::CurrentEpoch();
+  if (epoch && path.statEpoch.load(std::memory_order_acquire) == epoch) {
+    modtimeOut = time_t(path.statModtime.load(std::memory_order_relaxed));
+    return ProjectPath::Type(path.statType.load(std::memory_order_relaxed));
+  }
+
+  ProjectPath::Type type = ProjectPath::Type::None;
+  modtimeOut = 0;
+  Sstat theStat;
+  if (!hecl::Stat(path.absPath.data(), &theStat)) {
+    if (S_ISDIR(theStat.st_mode)) {
+      type = ProjectPath::Type::Directory;
+    } else if (S_ISREG(theStat.st_mode)) {
+      type = ProjectPath::Type::File;
+      modtimeOut = theStat.st_mtime;
+    }
+  }
+
+  if (epoch) {
+    path.statType.store(uint8_t(type), std::memory_order_relaxed);
+    path.statModtime.store(int64_t(modtimeOut), std::memory_order_relaxed);
+    path.statEpoch.store(epoch, std::memory_order_release);
+  }
+  return type;
+}
+
 ProjectPath::Type ProjectPath::getPathType() const {
-  if (m_absPath.empty())
+  const SystemStringView absPath = m_path->absPath;
+  if (absPath.empty())
     return Type::None;
-  if (m_absPath.find(_SYS_STR('*')) != SystemString::npos)
+  if (absPath.find(_SYS_STR('*')) != SystemStringView::npos)
     return Type::Glob;
-  Sstat theStat;
-  if (hecl::Stat(m_absPath.c_str(), &theStat))
-    return Type::None;
-  if (S_ISDIR(theStat.st_mode))
-    return Type::Directory;
-  if (S_ISREG(theStat.st_mode))
-    return Type::File;
-  return Type::None;
+  time_t modtime;
+  return StatPath(*m_path, modtime);
 }
 
 Time ProjectPath::getModtime() const {
-  Sstat theStat;
+  const SystemStringView absPath = m_path->absPath;
+  const uint64_t epoch = StatCacheSession::CurrentEpoch();
+  if (epoch && m_path->modtimeEpoch.load(std::memory_order_acquire) == epoch)
+    return Time(time_t(m_path->modtime.load(std::memory_order_relaxed)));
+
   time_t latestTime = 0;
-  if (m_absPath.find(_SYS_STR('*')) != SystemString::npos) {
+  time_t fileTime;
+  if (absPath.find(_SYS_STR('*')) != SystemStringView::npos) {
     std::vector<ProjectPath> globResults;
     getGlobResults(globResults);
-    for (ProjectPath& path : globResults) {
-      if (!hecl::Stat(path.getAbsolutePath().data(), &theStat)) {
-        if (S_ISREG(theStat.st_mode) && theStat.st_mtime > latestTime)
-          latestTime = theStat.st_mtime;
+    for (const ProjectPath& path : globResults)
+      if (StatPath(*path.m_path, fileTime) == Type::File && fileTime > latestTime)
+        latestTime = fileTime;
+  } else {
+    switch (StatPath(*m_path, latestTime)) {
+    case Type::File:
+      break;
+    case Type::Directory: {
+      hecl::DirectoryStream ds(absPath, true);
+      for (const hecl::DirectoryStream::Entry& ent : ds) {
+        if (ent.m_isDir)
+          continue;
+        if (StatPath(*ProjectPath(*this, ent.m_name).m_path, fileTime) == Type::File && fileTime > latestTime)
+          latestTime = fileTime;
       }
+      break;
     }
-    return Time(latestTime);
-  }
-  if (!hecl::Stat(m_absPath.c_str(), &theStat)) {
-    if (S_ISREG(theStat.st_mode)) {
-      return Time(theStat.st_mtime);
-    } else if (S_ISDIR(theStat.st_mode)) {
-      hecl::DirectoryEnumerator de(m_absPath, hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false, false, true);
-      for (const hecl::DirectoryEnumerator::Entry& ent : de) {
-        if (!hecl::Stat(ent.m_path.c_str(), &theStat)) {
-          if (S_ISREG(theStat.st_mode) && theStat.st_mtime > latestTime)
-            latestTime = theStat.st_mtime;
-        }
-      }
-      return Time(latestTime);
+    default:
+      LogModule.report(logvisor::Fatal, FMT_STRING(_SYS_STR("invalid path type for computing modtime in '{}'")),
+                       absPath);
+      return Time();
     }
   }
-  LogModule.report(logvisor::Fatal, FMT_STRING(_SYS_STR("invalid path type for computing modtime in '{}'")), m_absPath);
-  return Time();
-}
 
-static void _recursiveGlob(Database::Project& proj, std::vector<ProjectPath>& outPaths, const SystemString& remPath,
-                           const SystemString& itStr, bool needSlash) {
-  SystemRegexMatch matches;
-  if (!std::regex_search(remPath, matches, regPATHCOMP))
-    return;
+  if (epoch) {
+    m_path->modtime.store(int64_t(latestTime), std::memory_order_relaxed);
+    m_path->modtimeEpoch.store(epoch, std::memory_order_release);
+  }
+  return Time(latestTime);
+}
 
-  const SystemString& comp = matches[1];
-  if (comp.find(_SYS_STR('*')) == SystemString::npos) {
-    SystemString nextItStr = itStr;
-    if (needSlash)
-      nextItStr += _SYS_STR('/');
-    nextItStr += comp;
+namespace {
+/* fnmatch-style matcher for one path component: '*' matches any run of characters and '[...]'
+ * (or '[!...]') one character of a set of ranges. There is no '?', since path canonicalization
+ * replaces it with '_' like the other characters SanitizePath rejects. */
+class GlobComponent {
+  enum class Op : uint8_t { Char, Star, Class };
+  struct Token {
+    Op op;
+    bool negate = false;
+    SystemChar ch = 0;
+    uint32_t rangeBegin = 0;
+    uint32_t rangeEnd = 0;
+  };
+  std::vector<Token> m_tokens;
+  std::vector<std::pair<SystemChar, SystemChar>> m_ranges;
+  SystemString m_literal;
+
+  bool matchOne(const Token& tok, SystemChar ch) const {
+    switch (tok.op) {
+    case Op::Char:
+      return ch == tok.ch;
+    case Op::Class: {
+      bool inClass = false;
+      for (uint32_t i = tok.rangeBegin; i < tok.rangeEnd && !inClass; ++i)
+        inClass = ch >= m_ranges[i].first && ch <= m_ranges[i].second;
+      return inClass != tok.negate;
+    }
+    default:
+      return false;
+    }
+  }
 
-    hecl::Sstat theStat;
-    if (Stat(nextItStr.c_str(), &theStat))
+public:
+  /* Components without '*' are looked up directly rather than matched */
+  explicit GlobComponent(SystemStringView comp) {
+    if (comp.find(_SYS_STR('*')) == SystemStringView::npos) {
+      m_literal = comp;
       return;
+    }
 
-    if (S_ISDIR(theStat.st_mode))
-      _recursiveGlob(proj, outPaths, matches.suffix().str(), nextItStr, true);
-    else
-      outPaths.emplace_back(proj, nextItStr);
-    return;
+    for (size_t i = 0; i < comp.size(); ++i) {
+      const SystemChar ch = comp[i];
+      if (ch == _SYS_STR('*')) {
+        if (m_tokens.empty() || m_tokens.back().op != Op::Star)
+          m_tokens.push_back({Op::Star});
+      } else if (ch == _SYS_STR('[') && comp.find(_SYS_STR(']'), i + 2) != SystemStringView::npos) {
+        Token tok{Op::Class};
+        size_t j = i + 1;
+        if (comp[j] == _SYS_STR('!') || comp[j] == _SYS_STR('^')) {
+          tok.negate = true;
+          ++j;
+        }
+        tok.rangeBegin = uint32_t(m_ranges.size());
+        /* A leading ']' is a member of the set */
+        for (bool first = true; j < comp.size() && (first || comp[j] != _SYS_STR(']')); first = false) {
+          SystemChar lo = comp[j++];
+          SystemChar hi = lo;
+          if (j + 1 < comp.size() && comp[j] == _SYS_STR('-') && comp[j + 1] != _SYS_STR(']')) {
+            hi = comp[j + 1];
+            j += 2;
+          }
+          m_ranges.emplace_back(lo, hi);
+        }
+        if (j == comp.size()) {
+          /* Unterminated set; treat '[' as a plain character */
+          m_ranges.resize(tok.rangeBegin);
+          m_tokens.push_back({Op::Char, false, ch});
+          continue;
+        }
+        tok.rangeEnd = uint32_t(m_ranges.size());
+        m_tokens.push_back(tok);
+        i = j;
+      } else {
+        m_tokens.push_back({Op::Char, false, ch});
+      }
+    }
   }
 
-  /* Compile component into regex */
-  SystemRegex regComp(comp, SystemRegex::ECMAScript);
+  bool isLiteral() const { return m_tokens.empty(); }
+  SystemStringView literal() const { return m_literal; }
+
+  /* Linear scan, backtracking only to the most recent '*' */
+  bool match(SystemStringView name) const {
+    size_t t = 0;
+    size_t n = 0;
+    size_t starT = SIZE_MAX;
+    size_t starN = 0;
+    while (n < name.size()) {
+      if (t < m_tokens.size()) {
+        if (m_tokens[t].op == Op::Star) {
+          starT = t++;
+          starN = n;
+          continue;
+        }
+        if (matchOne(m_tokens[t], name[n])) {
+          ++t;
+          ++n;
+          continue;
+        }
+      }
+      if (starT == SIZE_MAX)
+        return false;
+      t = starT + 1;
+      n = ++starN;
+    }
+    while (t < m_tokens.size() && m_tokens[t].op == Op::Star)
+      ++t;
+    return t == m_tokens.size();
+  }
+};
+
+/* Compiled form of a glob path along with its expansion for the current stat cache epoch */
+struct GlobCacheEntry {
+  std::vector<GlobComponent> components;
+  std::mutex lock;
+  uint64_t epoch = 0;
+  std::vector<const ProjectPath::Interned*> results;
+
+  explicit GlobCacheEntry(SystemStringView relPath) {
+    SystemStringView comp;
+    while (NextPathComponent(relPath, comp, relPath))
+      components.emplace_back(comp);
+  }
+};
+
+/* Process-wide, like the interned paths the entries are keyed by */
+class GlobCache {
+  std::shared_mutex m_lock;
+  std::unordered_map<const ProjectPath::Interned*, std::unique_ptr<GlobCacheEntry>> m_entries;
+
+public:
+  GlobCacheEntry& get(const ProjectPath::Interned& path) {
+    {
+      std::shared_lock lk{m_lock};
+      if (auto search = m_entries.find(&path); search != m_entries.end())
+        return *search->second;
+    }
+    std::unique_lock lk{m_lock};
+    auto [it, inserted] = m_entries.try_emplace(&path);
+    if (inserted)
+      it->second = std::make_unique<GlobCacheEntry>(path.relPath);
+    return *it->second;
+  }
+};
 
-  hecl::DirectoryEnumerator de(itStr, hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false, false, true);
-  for (const hecl::DirectoryEnumerator::Entry& ent : de) {
-    if (std::regex_match(ent.m_name, regComp)) {
-      SystemString nextItStr = itStr;
-      if (needSlash)
-        nextItStr += '/';
-      nextItStr += ent.m_name;
-
-      hecl::Sstat theStat;
-      if (Stat(nextItStr.c_str(), &theStat))
-        continue;
+GlobCache& GetGlobCache() {
+  static GlobCache Cache;
+  return Cache;
+}
 
-      if (ent.m_isDir)
-        _recursiveGlob(proj, outPaths, matches.suffix().str(), nextItStr, true);
-      else
-        outPaths.emplace_back(proj, nextItStr);
+/* Directories only continue the walk and files only match the final component, so matches
+ * are told apart with the enumerator's classification alone */
+void RecursiveGlob(const std::vector<GlobComponent>& comps, size_t idx, const ProjectPath& dir,
+                   std::vector<ProjectPath>& outPaths) {
+  const GlobComponent& comp = comps[idx];
+  const bool last = idx + 1 == comps.size();
+  if (comp.isLiteral()) {
+    ProjectPath next(dir, comp.literal());
+    switch (next.getPathType()) {
+    case ProjectPath::Type::Directory:
+      if (!last)
+        RecursiveGlob(comps, idx + 1, next, outPaths);
+      break;
+    case ProjectPath::Type::File:
+      if (last)
+        outPaths.push_back(std::move(next));
+      break;
+    default:
+      break;
     }
+    return;
+  }
+
+  hecl::DirectoryEnumerator de(dir.getAbsolutePath(), hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false,
+                               false, true);
+  for (const hecl::DirectoryEnumerator::Entry& ent : de) {
+    if (ent.m_isDir == last || !comp.match(ent.m_name))
+      continue;
+    if (last)
+      outPaths.emplace_back(dir, ent.m_name);
+    else
+      RecursiveGlob(comps, idx + 1, ProjectPath(dir, ent.m_name), outPaths);
   }
 }
+} // anonymous namespace
 
 void ProjectPath::getDirChildren(std::map<SystemString, ProjectPath>& outPaths) const {
-  hecl::DirectoryEnumerator de(m_absPath, hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false, false, true);
-  for (const hecl::DirectoryEnumerator::Entry& ent : de)
+  hecl::DirectoryStream ds(m_path->absPath, true);
+  for (const hecl::DirectoryStream::Entry& ent : ds)
     outPaths[ent.m_name] = ProjectPath(*this, ent.m_name);
 }
 
 hecl::DirectoryEnumerator ProjectPath::enumerateDir() const {
-  return hecl::DirectoryEnumerator(m_absPath, hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false, false, true);
+  return hecl::DirectoryEnumerator(m_path->absPath, hecl::DirectoryEnumerator::Mode::DirsThenFilesSorted, false, false,
+                                   true);
 }
 
 void ProjectPath::getGlobResults(std::vector<ProjectPath>& outPaths) const {
-  auto rootPath = m_proj->getProjectRootPath().getAbsolutePath();
-  _recursiveGlob(*m_proj, outPaths, m_relPath, rootPath.data(), rootPath.back() != _SYS_STR('/'));
+  GlobCacheEntry& entry = GetGlobCache().get(*m_path);
+  const uint64_t epoch = StatCacheSession::CurrentEpoch();
+  std::unique_lock lk{entry.lock};
+  if (!epoch || entry.epoch != epoch) {
+    std::vector<ProjectPath> results;
+    if (!entry.components.empty())
+      RecursiveGlob(entry.components, 0, ProjectPath(*m_proj, _SYS_STR(".")), results);
+    entry.results.clear();
+    entry.results.reserve(results.size());
+    for (const ProjectPath& result : results)
+      entry.results.push_back(result.m_path);
+    entry.epoch = epoch;
+  }
+
+  outPaths.reserve(outPaths.size() + entry.results.size());
+  for (const Interned* result : entry.results) {
+    ProjectPath& path = outPaths.emplace_back();
+    path.m_proj = m_proj;
+    path.m_path = result;
+  }
 }
 
 template <typename T>
@@ -268,9 +580,9 @@ static bool RegexSearchLast(const T& str, std::match_results<typename T::const_i
 static const hecl::SystemRegex regParsedHash32(_SYS_STR(R"(_([0-9a-fA-F]{8}))"),
                                                std::regex::ECMAScript | std::regex::optimize);
 uint32_t ProjectPath::parsedHash32() const {
-  if (!m_auxInfo.empty()) {
-    hecl::SystemRegexMatch match;
-    if (RegexSearchLast(m_auxInfo, match, regParsedHash32)) {
+  if (!getAuxInfo().empty()) {
+    hecl::SystemViewRegexMatch match;
+    if (RegexSearchLast(getAuxInfo(), match, regParsedHash32)) {
       auto hexStr = match[1].str();
       if (auto val = hecl::StrToUl(hexStr.c_str(), nullptr, 16))
         return val;
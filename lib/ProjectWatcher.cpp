@@ -0,0 +1,144 @@
+#include "hecl/ProjectWatcher.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <unordered_set>
+
+#include "hecl/Database.hpp"
+
+#include <logvisor/logvisor.hpp>
+
+#if __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace hecl {
+static logvisor::Module Log("hecl::ProjectWatcher");
+
+#if __linux__
+constexpr uint32_t WatchMask =
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_ONLYDIR;
+#endif
+
+ProjectWatcher::ProjectWatcher(Database::Project& project) : m_project(project) {
+#if __linux__
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0) {
+    Log.report(logvisor::Error, FMT_STRING("inotify_init1: {}"), strerror(errno));
+    return;
+  }
+  _addWatches(ProjectPath(project, _SYS_STR(".")));
+#endif
+}
+
+ProjectWatcher::~ProjectWatcher() {
+#if __linux__
+  if (m_fd >= 0)
+    close(m_fd);
+#endif
+}
+
+void ProjectWatcher::_addWatches(const ProjectPath& dir) {
+#if __linux__
+  const int wd = inotify_add_watch(m_fd, dir.getAbsolutePath().data(), WatchMask);
+  if (wd < 0) {
+    Log.report(logvisor::Warning, FMT_STRING("unable to watch {}: {}"), dir.getAbsolutePath(), strerror(errno));
+    return;
+  }
+  m_watches.insert_or_assign(wd, dir);
+
+  DirectoryStream ds(dir.getAbsolutePath(), true);
+  for (const DirectoryStream::Entry& ent : ds)
+    if (ent.m_isDir)
+      _addWatches(ProjectPath(dir, ent.m_name));
+#endif
+}
+
+bool ProjectWatcher::_readEvents(std::vector<ProjectPath>& changedOut, bool& structuralOut) {
+#if __linux__
+  alignas(inotify_event) char buf[16384];
+  for (;;) {
+    const ssize_t len = read(m_fd, buf, sizeof(buf));
+    if (len < 0) {
+      if (errno == EAGAIN)
+        return true;
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Error, FMT_STRING("unable to read inotify events: {}"), strerror(errno));
+      return false;
+    }
+
+    for (const char* ptr = buf; ptr < buf + len;) {
+      const auto* ev = reinterpret_cast<const inotify_event*>(ptr);
+      ptr += sizeof(inotify_event) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {
+        /* Events were dropped; everything may have changed */
+        structuralOut = true;
+        changedOut.emplace_back(m_project, _SYS_STR("."));
+        continue;
+      }
+      if (ev->mask & IN_IGNORED) {
+        m_watches.erase(ev->wd);
+        continue;
+      }
+      auto search = m_watches.find(ev->wd);
+      if (search == m_watches.end() || !ev->len || ev->name[0] == '.')
+        continue;
+
+      if (ev->mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO))
+        structuralOut = true;
+      /* New files are reported once written */
+      if ((ev->mask & IN_CREATE) && !(ev->mask & IN_ISDIR))
+        continue;
+
+      search->second.invalidateStat();
+      ProjectPath path(search->second, ev->name);
+      path.invalidateStat();
+      if ((ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)))
+        _addWatches(path);
+      changedOut.push_back(std::move(path));
+    }
+  }
+#else
+  return false;
+#endif
+}
+
+bool ProjectWatcher::waitForChanges(std::vector<ProjectPath>& changedOut, std::chrono::milliseconds debounce) {
+#if __linux__
+  std::vector<ProjectPath> changed;
+  bool structural = false;
+  pollfd pfd{m_fd, POLLIN, 0};
+  for (;;) {
+    const int res = poll(&pfd, 1, changed.empty() ? -1 : int(debounce.count()));
+    if (res < 0) {
+      if (errno == EINTR)
+        continue;
+      Log.report(logvisor::Error, FMT_STRING("unable to poll inotify: {}"), strerror(errno));
+      return false;
+    }
+    if (res == 0)
+      break;
+    if (!_readEvents(changed, structural))
+      return false;
+  }
+
+  /* Creations, deletions and renames may change directory listings and glob expansions */
+  if (structural)
+    StatCacheSession::Invalidate();
+
+  std::unordered_set<uint64_t> seen;
+  changedOut.reserve(changedOut.size() + changed.size());
+  for (ProjectPath& path : changed)
+    if (seen.insert(path.hash().val64()).second)
+      changedOut.push_back(std::move(path));
+  return true;
+#else
+  return false;
+#endif
+}
+
+} // namespace hecl
@@ -3,22 +3,103 @@
 #include "hecl/Runtime.hpp"
 
 #include <athena/MemoryReader.hpp>
+#include <athena/MemoryWriter.hpp>
 #include <logvisor/logvisor.hpp>
 
 namespace hecl::Runtime {
 static logvisor::Module HMDL_Log("HMDL");
 
+/* Pipelines take their vertex layout from the shader (ShaderTag::vertexFormat), which declares
+ * float positions, normals, UVs and weights; packed attributes are expanded to that layout on load */
+static std::unique_ptr<uint8_t[]> UnpackVertices(const HMDLMeta& meta, const void* vbo, atUint32 floatStride) {
+  auto ret = std::make_unique<uint8_t[]>(size_t(meta.vertCount) * floatStride);
+  athena::io::MemoryReader r(vbo, size_t(meta.vertCount) * meta.vertStride);
+  athena::io::MemoryWriter w(ret.get(), size_t(meta.vertCount) * floatStride);
+  const athena::simd_floats posMin(meta.posMin.simd);
+  const athena::simd_floats posScale(meta.posScale.simd);
+
+  for (atUint32 v = 0; v < meta.vertCount; ++v) {
+    if (True(meta.flags & HMDLFlags::PackedPositions)) {
+      for (int i = 0; i < 3; ++i)
+        w.writeFloatLittle(posMin[i] + r.readUint16Little() / 65535.f * posScale[i]);
+      r.readUint16Little();
+    } else {
+      w.writeVec3fLittle(r.readVec3fLittle());
+    }
+
+    if (True(meta.flags & HMDLFlags::OctNormals)) {
+      const atInt16 oct[2] = {r.readInt16Little(), r.readInt16Little()};
+      float n[3];
+      OctDecodeNormal(oct, n);
+      for (float c : n)
+        w.writeFloatLittle(c);
+    } else {
+      w.writeVec3fLittle(r.readVec3fLittle());
+    }
+
+    for (atUint32 i = 0; i < meta.colorCount; ++i)
+      w.writeUint32Little(r.readUint32Little());
+
+    for (atUint32 i = 0; i < meta.uvCount; ++i) {
+      if (True(meta.flags & HMDLFlags::HalfUVs)) {
+        w.writeFloatLittle(HalfToFloat(r.readUint16Little()));
+        w.writeFloatLittle(HalfToFloat(r.readUint16Little()));
+      } else {
+        w.writeVec2fLittle(r.readVec2fLittle());
+      }
+    }
+
+    for (atUint32 i = 0; i < meta.weightCount; ++i) {
+      if (True(meta.flags & HMDLFlags::PackedWeights)) {
+        for (int j = 0; j < 4; ++j)
+          w.writeFloatLittle(r.readUByte() / 255.f);
+      } else {
+        w.writeVec4fLittle(r.readVec4fLittle());
+      }
+    }
+  }
+  return ret;
+}
+
 HMDLData::HMDLData(boo::IGraphicsDataFactory::Context& ctx, const void* metaData, const void* vbo, const void* ibo) {
   HMDLMeta meta;
   {
+    /* Check magic and version before reading the rest, which is laid out per version */
     athena::io::MemoryReader r(metaData, HECL_HMDL_META_SZ);
+    meta.magic = r.readUint32Big();
+    if (meta.magic != 'TACO')
+      HMDL_Log.report(logvisor::Fatal, FMT_STRING("invalid HMDL magic"));
+    meta.version = r.readUint32Big();
+    if (meta.version != HMDLMetaVersion)
+      HMDL_Log.report(logvisor::Fatal, FMT_STRING("HMDL version {} does not match {}; recook the model"),
+                      meta.version, HMDLMetaVersion);
+    r.seek(0, athena::SeekOrigin::Begin);
     meta.read(r);
   }
-  if (meta.magic != 'TACO')
-    HMDL_Log.report(logvisor::Fatal, FMT_STRING("invalid HMDL magic"));
 
-  m_vbo = ctx.newStaticBuffer(boo::BufferUse::Vertex, vbo, meta.vertStride, meta.vertCount);
-  m_ibo = ctx.newStaticBuffer(boo::BufferUse::Index, ibo, 4, meta.indexCount);
+  if (meta.vertStride != HMDLVertStride(meta.flags, meta.colorCount, meta.uvCount, meta.weightCount))
+    HMDL_Log.report(logvisor::Fatal, FMT_STRING("HMDL vertex stride {} does not match its attributes"),
+                    meta.vertStride);
+
+  if (True(meta.flags & HMDLFlags::VertexPackingMask)) {
+    const atUint32 floatStride = HMDLVertStride(HMDLFlags::None, meta.colorCount, meta.uvCount, meta.weightCount);
+    std::unique_ptr<uint8_t[]> floatVbo = UnpackVertices(meta, vbo, floatStride);
+    m_vbo = ctx.newStaticBuffer(boo::BufferUse::Vertex, floatVbo.get(), floatStride, meta.vertCount);
+  } else {
+    m_vbo = ctx.newStaticBuffer(boo::BufferUse::Vertex, vbo, meta.vertStride, meta.vertCount);
+  }
+  if (True(meta.flags & HMDLFlags::ShortIndices)) {
+    /* boo binds index buffers as 32-bit; widen, restoring the 32-bit restart index */
+    auto wideIbo = std::make_unique<atUint32[]>(meta.indexCount);
+    athena::io::MemoryReader r(ibo, size_t(meta.indexCount) * 2);
+    for (atUint32 i = 0; i < meta.indexCount; ++i) {
+      const atUint16 idx = r.readUint16Little();
+      wideIbo[i] = idx == 0xffff ? 0xffffffff : idx;
+    }
+    m_ibo = ctx.newStaticBuffer(boo::BufferUse::Index, wideIbo.get(), 4, meta.indexCount);
+  } else {
+    m_ibo = ctx.newStaticBuffer(boo::BufferUse::Index, ibo, 4, meta.indexCount);
+  }
 
   const size_t elemCount = 2 + meta.colorCount + meta.uvCount + meta.weightCount;
   m_vtxFmtData = std::make_unique<boo::VertexElementDescriptor[]>(elemCount);
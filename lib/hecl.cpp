@@ -205,13 +205,50 @@ bool IsPathYAML(const hecl::ProjectPath& path) {
   return lastCompExt == _SYS_STR("yaml") || lastCompExt == _SYS_STR("yml");
 }
 
+#if !_WIN32
+/* Classifies a readdir entry from d_type where the filesystem reports it, only stat'ing
+ * symlinks, untyped entries and files whose size is requested */
+static bool ClassifyDirent(DIR* dir, const dirent* d, bool needSize, bool& isDir, size_t& sz) {
+  isDir = false;
+  sz = 0;
+#ifdef DT_UNKNOWN
+  switch (d->d_type) {
+  case DT_DIR:
+    isDir = true;
+    return true;
+  case DT_REG:
+    if (!needSize)
+      return true;
+    break;
+  case DT_LNK:
+  case DT_UNKNOWN:
+    break;
+  default:
+    return false;
+  }
+#endif
+  hecl::Sstat st;
+  if (fstatat(dirfd(dir), d->d_name, &st, 0))
+    return false;
+  if (S_ISDIR(st.st_mode)) {
+    isDir = true;
+    return true;
+  }
+  if (S_ISREG(st.st_mode)) {
+    sz = st.st_size;
+    return true;
+  }
+  return false;
+}
+#endif
+
 hecl::DirectoryEnumerator::DirectoryEnumerator(SystemStringView path, Mode mode, bool sizeSort, bool reverse,
                                                bool noHidden) {
+#if _WIN32
   hecl::Sstat theStat;
   if (hecl::Stat(path.data(), &theStat) || !S_ISDIR(theStat.st_mode))
     return;
 
-#if _WIN32
   hecl::SystemString wc(path);
   wc += _SYS_STR("/*");
   WIN32_FIND_DATAW d;
@@ -333,117 +370,118 @@ hecl::DirectoryEnumerator::DirectoryEnumerator(SystemStringView path, Mode mode,
   DIR* dir = opendir(path.data());
   if (!dir)
     return;
-  const dirent* d;
-  switch (mode) {
-  case Mode::Native:
-    while ((d = readdir(dir))) {
-      if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
-        continue;
-      if (noHidden && d->d_name[0] == '.')
-        continue;
-      hecl::SystemString fp(path);
-      fp += '/';
-      fp += d->d_name;
-      hecl::Sstat st;
-      if (hecl::Stat(fp.c_str(), &st))
-        continue;
 
-      size_t sz = 0;
-      bool isDir = false;
-      if (S_ISDIR(st.st_mode))
-        isDir = true;
-      else if (S_ISREG(st.st_mode))
-        sz = st.st_size;
-      else
-        continue;
-
-      m_entries.push_back(Entry(std::move(fp), d->d_name, sz, isDir));
-    }
-    break;
-  case Mode::DirsThenFilesSorted:
-  case Mode::DirsSorted: {
-    std::map<hecl::SystemString, Entry, CaseInsensitiveCompare> sort;
-    while ((d = readdir(dir))) {
-      if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
-        continue;
-      if (noHidden && d->d_name[0] == '.')
-        continue;
-      hecl::SystemString fp(path);
-      fp += '/';
-      fp += d->d_name;
-      hecl::Sstat st;
-      if (hecl::Stat(fp.c_str(), &st) || !S_ISDIR(st.st_mode))
-        continue;
-      sort.emplace(std::make_pair(d->d_name, Entry(std::move(fp), d->d_name, 0, true)));
-    }
-
-    if (reverse)
-      for (auto it = sort.crbegin(); it != sort.crend(); ++it)
-        m_entries.push_back(std::move(it->second));
-    else
-      for (auto& e : sort)
-        m_entries.push_back(std::move(e.second));
-
-    if (mode == Mode::DirsSorted)
-      break;
-    rewinddir(dir);
-    [[fallthrough]];
+  /* Single pass; sorted modes order a flat vector afterwards */
+  const bool wantDirs = mode != Mode::FilesSorted;
+  const bool wantFiles = mode != Mode::DirsSorted;
+  const dirent* d;
+  while ((d = readdir(dir))) {
+    if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
+      continue;
+    if (noHidden && d->d_name[0] == '.')
+      continue;
+    bool isDir;
+    size_t sz;
+    if (!ClassifyDirent(dir, d, sizeSort && wantFiles, isDir, sz) || !(isDir ? wantDirs : wantFiles))
+      continue;
+    hecl::SystemString fp(path);
+    fp += '/';
+    fp += d->d_name;
+    m_entries.emplace_back(std::move(fp), d->d_name, sz, isDir);
   }
-  case Mode::FilesSorted: {
-    if (mode == Mode::FilesSorted)
-      m_entries.clear();
+  closedir(dir);
 
-    if (sizeSort) {
-      std::multimap<size_t, Entry> sort;
-      while ((d = readdir(dir))) {
-        if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
-          continue;
-        if (noHidden && d->d_name[0] == '.')
-          continue;
-        hecl::SystemString fp(path);
-        fp += '/';
-        fp += d->d_name;
-        hecl::Sstat st;
-        if (hecl::Stat(fp.c_str(), &st) || !S_ISREG(st.st_mode))
-          continue;
-        sort.emplace(std::make_pair(st.st_size, Entry(std::move(fp), d->d_name, st.st_size, false)));
-      }
+  if (mode == Mode::Native)
+    return;
 
-      if (reverse)
-        for (auto it = sort.crbegin(); it != sort.crend(); ++it)
-          m_entries.push_back(std::move(it->second));
-      else
-        for (auto& e : sort)
-          m_entries.push_back(std::move(e.second));
-    } else {
-      std::map<hecl::SystemString, Entry, CaseInsensitiveCompare> sort;
-      while ((d = readdir(dir))) {
-        if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
-          continue;
-        if (noHidden && d->d_name[0] == '.')
-          continue;
-        hecl::SystemString fp(path);
-        fp += '/';
-        fp += d->d_name;
-        hecl::Sstat st;
-        if (hecl::Stat(fp.c_str(), &st) || !S_ISREG(st.st_mode))
-          continue;
-        sort.emplace(std::make_pair(d->d_name, Entry(std::move(fp), d->d_name, st.st_size, false)));
-      }
+  /* Names differing only in case fall back to a case-sensitive compare so the order doesn't depend on readdir */
+  const auto nameLess = [](const Entry& a, const Entry& b) {
+    if (CaseInsensitiveCompare()(a.m_name, b.m_name))
+      return true;
+    if (CaseInsensitiveCompare()(b.m_name, a.m_name))
+      return false;
+    return a.m_name < b.m_name;
+  };
+  const auto filesBegin =
+      std::stable_partition(m_entries.begin(), m_entries.end(), [](const Entry& e) { return e.m_isDir; });
+  std::sort(m_entries.begin(), filesBegin, nameLess);
+  if (sizeSort)
+    std::stable_sort(filesBegin, m_entries.end(),
+                     [](const Entry& a, const Entry& b) { return a.m_fileSz < b.m_fileSz; });
+  else
+    std::sort(filesBegin, m_entries.end(), nameLess);
+  if (reverse) {
+    std::reverse(m_entries.begin(), filesBegin);
+    std::reverse(filesBegin, m_entries.end());
+  }
+#endif
+}
 
-      if (reverse)
-        for (auto it = sort.crbegin(); it != sort.crend(); ++it)
-          m_entries.push_back(std::move(it->second));
-      else
-        for (auto& e : sort)
-          m_entries.push_back(std::move(e.second));
-    }
+DirectoryStream::DirectoryStream(SystemStringView path, bool noHidden) : m_path(path), m_noHidden(noHidden) {
+#if _WIN32
+  hecl::SystemString wc(path);
+  wc += _SYS_STR("/*");
+  m_handle = FindFirstFileW(wc.c_str(), &m_findData);
+  m_pending = m_handle != INVALID_HANDLE_VALUE;
+#else
+  m_handle = opendir(m_path.c_str());
+#endif
+}
 
-    break;
-  }
-  }
-  closedir(dir);
+DirectoryStream::~DirectoryStream() {
+#if _WIN32
+  if (m_handle != INVALID_HANDLE_VALUE)
+    FindClose(m_handle);
+#else
+  if (m_handle)
+    closedir(static_cast<DIR*>(m_handle));
+#endif
+}
 
+bool DirectoryStream::next() {
+#if _WIN32
+  if (m_handle == INVALID_HANDLE_VALUE)
+    return false;
+  for (; m_pending || FindNextFileW(m_handle, &m_findData); m_pending = false) {
+    const WIN32_FIND_DATAW& d = m_findData;
+    if (!wcscmp(d.cFileName, _SYS_STR(".")) || !wcscmp(d.cFileName, _SYS_STR("..")))
+      continue;
+    if (m_noHidden && (d.cFileName[0] == L'.' || (d.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0))
+      continue;
+    m_entry.m_path = m_path;
+    m_entry.m_path += _SYS_STR('/');
+    m_entry.m_path += d.cFileName;
+    hecl::Sstat st;
+    if (hecl::Stat(m_entry.m_path.c_str(), &st))
+      continue;
+    m_entry.m_isDir = S_ISDIR(st.st_mode);
+    if (!m_entry.m_isDir && !S_ISREG(st.st_mode))
+      continue;
+    m_entry.m_name = d.cFileName;
+    m_entry.m_fileSz = m_entry.m_isDir ? 0 : st.st_size;
+    m_pending = false;
+    return true;
+  }
+  return false;
+#else
+  DIR* dir = static_cast<DIR*>(m_handle);
+  if (!dir)
+    return false;
+  const dirent* d;
+  while ((d = readdir(dir))) {
+    if (!strcmp(d->d_name, ".") || !strcmp(d->d_name, ".."))
+      continue;
+    if (m_noHidden && d->d_name[0] == '.')
+      continue;
+    if (!ClassifyDirent(dir, d, false, m_entry.m_isDir, m_entry.m_fileSz))
+      continue;
+    m_entry.m_path = m_path;
+    m_entry.m_path += '/';
+    m_entry.m_path += d->d_name;
+    m_entry.m_name = d->d_name;
+    return true;
+  }
+  return false;
 #endif
 }
 